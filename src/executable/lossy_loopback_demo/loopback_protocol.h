@@ -0,0 +1,53 @@
+#pragma once
+
+#include <library/message.h>
+
+#include <cstdint>
+
+
+enum class loopback_message_indicator : std::uint8_t
+{
+    update = 1
+};
+
+
+using loopback_protocol = bcpp::message::protocol
+        <
+            bcpp::message::protocol_traits<"loopback_protocol", {1, 0, 'a'}, loopback_message_indicator>, 
+            loopback_message_indicator::update
+        >;
+
+
+namespace bcpp::message
+{
+
+    #pragma pack(push, 1)
+    template <>
+    struct message_header<loopback_protocol>
+    {
+        using protocol = loopback_protocol;
+        message_header(loopback_message_indicator messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        loopback_message_indicator  messageIndicator_;
+        std::uint16_t               size_;
+    };
+
+
+    // a sequenced message (the message sequence is independent of the packet sequence of the framing layer)
+    template <>
+    struct message<loopback_protocol, loopback_message_indicator::update> :
+        message_header<loopback_protocol>
+    {
+        static auto constexpr type = loopback_message_indicator::update;
+        message(std::uint64_t sequence):message_header(type, sizeof(*this)), sequence_(sequence){}
+        static constexpr auto size(std::uint64_t){return sizeof(message);}
+        std::uint64_t   sequence_;
+        std::uint64_t   payload_[3]{};
+    };
+    #pragma pack(pop)
+
+} // namespace bcpp::message
+
+
+using update_message = bcpp::message::message<loopback_protocol, loopback_message_indicator::update>;
@@ -0,0 +1,182 @@
+#include "./loopback_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <span>
+#include <vector>
+
+
+namespace
+{
+
+    auto constexpr message_count = std::uint64_t(10'000'000);
+    auto constexpr loss_rate = 0.02;                // of every packet sent, including retransmissions
+    auto constexpr reorder_rate = 0.05;             // packets overtaken by the next few packets
+    auto constexpr reorder_depth = 8;
+    auto constexpr packets_in_flight = 32;          // latency of the network in packets
+    auto constexpr packet_capacity = std::size_t(1400);
+    auto constexpr retransmit_capacity = std::size_t(1 << 12);
+    auto constexpr reorder_capacity = std::size_t(1 << 10);
+    auto constexpr replay_timeout = std::chrono::microseconds(20); // a few network round trips
+
+    using packet_type = std::vector<char>;
+
+
+    //=========================================================================
+    // a single threaded stand in for a udp socket pair which loses and reorders datagrams
+    class lossy_network
+    {
+    public:
+
+        void send
+        (
+            std::span<char const> datagram
+        )
+        {
+            ++sent_;
+            if (random_(generator_) < loss_rate)
+            {
+                ++lost_;
+                return;
+            }
+            inFlight_.emplace_back(datagram.begin(), datagram.end());
+            if ((inFlight_.size() > reorder_depth) && (random_(generator_) < reorder_rate))
+                std::swap(inFlight_.back(), inFlight_[inFlight_.size() - 1 - (generator_() % reorder_depth)]);
+        }
+
+        // deliver the datagrams which have been in flight long enough (or all of them)
+        template <typename F>
+        void receive
+        (
+            F && f,
+            bool all = false
+        )
+        {
+            while ((!inFlight_.empty()) && ((all) || (inFlight_.size() > packets_in_flight)))
+            {
+                f(std::move(inFlight_.front()));
+                inFlight_.pop_front();
+            }
+        }
+
+        bool empty() const{return inFlight_.empty();}
+
+        std::uint64_t get_sent() const{return sent_;}
+
+        std::uint64_t get_lost() const{return lost_;}
+
+    private:
+
+        std::deque<packet_type>                 inFlight_;
+        std::mt19937_64                         generator_{0x5eed};
+        std::uniform_real_distribution<double>  random_{0.0, 1.0};
+        std::uint64_t                           sent_{0};
+        std::uint64_t                           lost_{0};
+    };
+
+
+    //=========================================================================
+    class update_recipient :
+        public bcpp::message::receiver<update_recipient, loopback_protocol, std::queue<packet_type>>
+    {
+    public:
+
+        // skip the sequence_header at the start of each packet
+        update_recipient():receiver({.packetHeadroom_ = sizeof(bcpp::message::sequence_header)}, {}){}
+
+        std::uint64_t get_messages_received() const{return messagesReceived_;}
+
+        std::uint64_t get_sequence_errors() const{return sequenceErrors_;}
+
+    private:
+
+        friend class receiver;
+
+        void operator()
+        (
+            update_message const & updateMessage
+        )
+        {
+            sequenceErrors_ += (updateMessage.sequence_ != messagesReceived_);
+            ++messagesReceived_;
+        }
+
+        std::uint64_t   messagesReceived_{0};
+        std::uint64_t   sequenceErrors_{0};
+    };
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    lossy_network network;
+    update_recipient recipient;
+
+    bcpp::message::sequencer<packet_type> sequencer({.retransmitCapacity_ = retransmit_capacity},
+            {.sendHandler_ = [&](std::span<char const> datagram){network.send(datagram);}});
+
+    // replay requests are made from the receiving side.  in this single threaded demo they can be
+    // forwarded to the sequencer directly.
+    bcpp::message::gap_detector<packet_type> gapDetector({.reorderCapacity_ = reorder_capacity, .replayTimeout_ = replay_timeout},
+            {
+                .packetHandler_ = [&](packet_type && packet){recipient << std::move(packet);},
+                .replayRequestHandler_ = [&](std::uint64_t first, std::size_t count){sequencer.retransmit(first, count);}
+            });
+
+    auto receive = [&](bool all)
+            {
+                network.receive([&](packet_type && datagram){gapDetector.push(std::move(datagram));}, all);
+                gapDetector.poll();
+                recipient.process_all();
+            };
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        auto transmitter = bcpp::message::make_transmitter<loopback_protocol, packet_type>(
+                {.packetCapacity_ = packet_capacity, .packetHeadroom_ = bcpp::message::sequencer<packet_type>::packet_headroom},
+                [](auto const &, std::size_t capacity){packet_type packet; packet.reserve(capacity); return packet;},
+                sequencer.get_packet_handler());
+        for (std::uint64_t i = 0; i < message_count; ++i)
+        {
+            transmitter.emplace<update_message>(i);
+            if ((i % 64) == 0)
+                receive(false);
+        }
+        transmitter.flush();
+    }
+
+    // the tail of the stream is recovered by reporting the last sequence sent (as a heartbeat would)
+    while (recipient.get_messages_received() < message_count)
+    {
+        gapDetector.notify_sequence(sequencer.get_next_sequence() - 1);
+        receive(true);
+        if (sequencer.get_statistics().unavailable_ > 0)
+            break; // unrecoverable
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+    auto messagesReceived = recipient.get_messages_received();
+    auto sequencerStatistics = sequencer.get_statistics();
+    auto gapDetectorStatistics = gapDetector.get_statistics();
+    std::cout << messagesReceived << " messages in " << elapsed.count() << " sec (" << (messagesReceived / elapsed.count()) << " msg/sec)\n" <<
+            "datagrams sent = " << network.get_sent() << ", lost = " << network.get_lost() << '\n' <<
+            "packets sent = " << sequencerStatistics.sent_ << ", retransmitted = " << sequencerStatistics.retransmitted_ <<
+            ", unavailable = " << sequencerStatistics.unavailable_ << '\n' <<
+            "replay requests = " << gapDetectorStatistics.replayRequests_ << ", reordered = " << gapDetectorStatistics.reordered_ <<
+            ", duplicates = " << gapDetectorStatistics.duplicates_ << ", overflows = " << gapDetectorStatistics.overflows_ << '\n' <<
+            "reorder buffer high water mark = " << gapDetectorStatistics.maxBuffered_ << " of " << reorder_capacity << " packets (" <<
+            ((gapDetectorStatistics.maxBuffered_ * packet_capacity) >> 10) << " KB)\n" <<
+            "sequence errors = " << recipient.get_sequence_errors() << '\n';
+    return ((messagesReceived == message_count) && (recipient.get_sequence_errors() == 0)) ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <library/message.h>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+
+namespace bench
+{
+
+    // a family of synthetic protocols used to exercise the library.  all messages share a common header
+    // and carry a single payload value.
+    template <typename I>
+    using protocol_traits = bcpp::message::protocol_traits<"bench_protocol", {1, 0, 'a'}, I>;
+
+    template <typename I, I ... Ns>
+    using protocol = bcpp::message::protocol<protocol_traits<I>, Ns ...>;
+
+
+    // a protocol with 'Count' message indicators: Offset, Offset + Stride, Offset + (2 * Stride), ...
+    // (wrapping at the width of the indicator type)
+    template <typename I, std::size_t Count, std::size_t Stride, std::size_t Offset>
+    using make_protocol = decltype([]<std::size_t ... N>(std::index_sequence<N ...>) -> 
+            protocol<I, static_cast<I>((Offset + (N * Stride)) & std::numeric_limits<I>::max()) ...>{return {};}
+            (std::make_index_sequence<Count>()));
+
+
+    // a protocol of fixed size messages of increasing payload size used to measure the transmit and receive 
+    // paths.  the largest message fills an entire default sized packet.
+    enum class payload_size : std::uint8_t
+    {
+        small = 1,
+        medium = 2,
+        max = 3
+    };
+
+    template <payload_size S>
+    static auto constexpr payload_message_size = (S == payload_size::small) ? 16 : (S == payload_size::medium) ? 256 : 2048;
+
+    using payload_protocol = bcpp::message::protocol
+            <
+                bcpp::message::protocol_traits<"bench_payload_protocol", {1, 0, 'a'}, payload_size>, 
+                payload_size::small, 
+                payload_size::medium,
+                payload_size::max
+            >;
+
+} // namespace bench
+
+
+namespace bcpp::message
+{
+
+    #pragma pack(push, 1)
+    template <typename I, I ... Ns>
+    struct message_header<bench::protocol<I, Ns ...>>
+    {
+        using protocol = bench::protocol<I, Ns ...>;
+        message_header(I messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        I               messageIndicator_;
+        std::uint16_t   size_;
+    };
+
+
+    template <typename I, I ... Ns, typename bench::protocol<I, Ns ...>::message_indicator M>
+    struct message<bench::protocol<I, Ns ...>, M> :
+        message_header<bench::protocol<I, Ns ...>>
+    {
+        static auto constexpr type = M;
+        message(std::uint64_t value = 0):message_header<bench::protocol<I, Ns ...>>(type, sizeof(*this)), value_(value){}
+        static constexpr auto size(){return sizeof(message);} // fixed sized message
+        std::uint64_t value_;
+    };
+
+
+    template <>
+    struct message_header<bench::payload_protocol>
+    {
+        using protocol = bench::payload_protocol;
+        message_header(bench::payload_size messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        bench::payload_size messageIndicator_;
+        std::uint16_t       size_;
+    };
+
+
+    template <bench::payload_protocol::message_indicator M>
+    struct message<bench::payload_protocol, M> :
+        message_header<bench::payload_protocol>
+    {
+        static auto constexpr type = M;
+        message(std::uint64_t value = 0):message_header(type, sizeof(*this)), value_(value){}
+        static constexpr auto size(){return sizeof(message);} // fixed sized message
+        std::uint64_t   value_;
+        char            payload_[bench::payload_message_size<M> - sizeof(message_header<bench::payload_protocol>) - sizeof(std::uint64_t)]{};
+    };
+    #pragma pack(pop)
+
+} // namespace bcpp::message
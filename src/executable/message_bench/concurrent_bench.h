@@ -0,0 +1,96 @@
+#pragma once
+
+#include "./bench_protocol.h"
+#include "./report.h"
+
+#include <library/message/transmitter/concurrent_transmitter.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace bench
+{
+
+    //=========================================================================
+    // 'producers' threads emplace 'messageCount' small messages between them onto either a
+    // concurrent_transmitter or (the baseline) a transmitter guarded by a mutex
+    template <bool concurrent>
+    result run_concurrent_transmit_bench
+    (
+        std::string name,
+        std::size_t producers,
+        std::size_t messageCount
+    )
+    {
+        using message = bcpp::message::message<payload_protocol, payload_size::small>;
+
+        std::atomic<std::size_t> bytesFlushed{0};
+        auto packetHandler = [&](auto const &, std::vector<char> packet){bytesFlushed += packet.size();};
+        auto packetAllocateHandler = [](auto const &, std::size_t capacity){std::vector<char> packet; packet.reserve(capacity); return packet;};
+
+        auto concurrentTransmitter = bcpp::message::make_concurrent_transmitter<payload_protocol, std::vector<char>>({}, packetAllocateHandler, packetHandler);
+        auto transmitter = bcpp::message::make_transmitter<payload_protocol, std::vector<char>>({}, packetAllocateHandler, packetHandler);
+        std::mutex mutex;
+
+        auto messagesPerProducer = (messageCount / producers);
+        std::atomic<std::size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < producers; ++i)
+            threads.emplace_back([&]()
+                    {
+                        ++ready;
+                        while (!go.load(std::memory_order_acquire))
+                            std::this_thread::yield();
+                        for (std::size_t j = 0; j < messagesPerProducer; ++j)
+                        {
+                            if constexpr (concurrent)
+                            {
+                                concurrentTransmitter->template emplace<message>(j);
+                            }
+                            else
+                            {
+                                std::lock_guard lockGuard(mutex);
+                                transmitter.template emplace<message>(j);
+                            }
+                        }
+                    });
+        while (ready.load() < producers)
+            std::this_thread::yield();
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto & thread : threads)
+            thread.join();
+        concurrentTransmitter->flush();
+        transmitter.flush();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return {std::move(name), messagesPerProducer * producers, elapsed, (bytesFlushed != (messagesPerProducer * producers * sizeof(message))) ? "lost messages" : ""};
+    }
+
+
+    //=========================================================================
+    inline void concurrent_transmit_bench
+    (
+        result_set & results,
+        std::size_t iterations
+    )
+    {
+        static auto constexpr producer_counts = std::array<std::size_t, 6>{1, 2, 4, 8, 16, 32};
+        auto messageCount = ((std::size_t(1) << 16) * iterations);
+        for (auto producers : producer_counts)
+        {
+            auto suffix = "/" + std::to_string(producers) + "_producers";
+            results.run("concurrent_emplace/mutex" + suffix, [&](std::string name){return run_concurrent_transmit_bench<false>(std::move(name), producers, messageCount);});
+            results.run("concurrent_emplace/concurrent_transmitter" + suffix, [&](std::string name){return run_concurrent_transmit_bench<true>(std::move(name), producers, messageCount);});
+        }
+    }
+
+} // namespace bench
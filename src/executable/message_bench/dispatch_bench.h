@@ -0,0 +1,266 @@
+#pragma once
+
+#include "./bench_protocol.h"
+#include "./report.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace bench
+{
+
+    //=========================================================================
+    // reproduction of the original receiver dispatch: a static table of function pointers sized to
+    // every possible value of the message indicator.
+    template <typename H, bcpp::message::protocol_concept P>
+    struct table_dispatcher
+    {
+        using message_indicator = typename P::message_indicator;
+        using underlying_message_indicator = bcpp::message::underlying_message_indicator_t<message_indicator>;
+        static auto constexpr max_underlying_message_indicator_value = (1 << (sizeof(underlying_message_indicator) * 8));
+
+        static bool dispatch
+        (
+            message_indicator messageIndicator,
+            H & h,
+            void const * address
+        )
+        {
+            if (auto callback = callback_[static_cast<underlying_message_indicator>(messageIndicator)]; callback != nullptr)
+            {
+                callback(h, address);
+                return true;
+            }
+            return false;
+        }
+
+        static inline std::array<void(*)(H &, void const *), max_underlying_message_indicator_value> callback_ = 
+                []<std::size_t ... N>(std::index_sequence<N ...>)
+                {
+                    std::array<void(*)(H &, void const *), max_underlying_message_indicator_value> callback{};
+                    ((callback[static_cast<underlying_message_indicator>(P::get(N))] = H::template dispatch_message<P::get(N)>), ...);
+                    return callback;
+                }(std::make_index_sequence<P::message_arity>());
+    };
+
+
+    //=========================================================================
+    template <bcpp::message::protocol_concept P>
+    struct dispatch_target
+    {
+        using message_indicator = typename P::message_indicator;
+
+        template <message_indicator M>
+        static constexpr bool handles(){return true;}
+
+        template <message_indicator M>
+        static void dispatch_message
+        (
+            dispatch_target & self,
+            void const * address
+        )
+        {
+            self.sum_ += (reinterpret_cast<bcpp::message::message<P, M> const *>(address)->value_ + static_cast<std::uint64_t>(M));
+        }
+
+        std::uint64_t sum_{0};
+    };
+
+
+    //=========================================================================
+    template <bcpp::message::protocol_concept P, typename P::message_indicator M>
+    void append_message
+    (
+        std::vector<char> & stream,
+        std::uint64_t value
+    )
+    {
+        bcpp::message::message<P, M> message(value);
+        stream.insert(stream.end(), reinterpret_cast<char const *>(&message), reinterpret_cast<char const *>(&message) + sizeof(message));
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::protocol_concept P>
+    std::vector<char> make_message_stream
+    (
+        std::size_t messageCount
+    )
+    {
+        using message_header = bcpp::message::message_header<P>;
+        static auto constexpr make_message = []<std::size_t ... N>(std::index_sequence<N ...>)
+                {
+                    return std::array<void(*)(std::vector<char> &, std::uint64_t), sizeof ... (N)>{append_message<P, P::get(N)> ...};
+                }(std::make_index_sequence<P::message_arity>());
+
+        std::mt19937_64 generator(messageCount);
+        std::vector<char> stream;
+        stream.reserve(messageCount * sizeof(message_header) * 4);
+        for (std::size_t i = 0; i < messageCount; ++i)
+            make_message[generator() % P::message_arity](stream, generator());
+        return stream;
+    }
+
+
+    //=========================================================================
+    template <template <typename, typename> class D, bcpp::message::protocol_concept P>
+    result run_dispatch_bench
+    (
+        std::string name,
+        std::vector<char> const & stream,
+        std::size_t iterations
+    )
+    {
+        using message_header = bcpp::message::message_header<P>;
+        using target = dispatch_target<P>;
+
+        target t;
+        std::size_t messages = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            for (auto current = stream.data(), end = stream.data() + stream.size(); current < end; )
+            {
+                auto const & messageHeader = *reinterpret_cast<message_header const *>(current);
+                D<target, P>::dispatch(messageHeader.get_message_indicator(), t, current);
+                current += messageHeader.size();
+                ++messages;
+            }
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return {std::move(name), messages, elapsed, (t.sum_ == 0) ? "no messages" : ""};
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::protocol_concept P>
+    struct subscription_target :
+        bcpp::message::receiver<subscription_target<P>, P, std::queue<std::vector<char>>>
+    {
+        using receiver = bcpp::message::receiver<subscription_target<P>, P, std::queue<std::vector<char>>>;
+
+        subscription_target
+        (
+            typename receiver::subscription_type const & subscriptions
+        ):
+            receiver({.subscriptions_ = subscriptions}, {})
+        {
+        }
+
+        template <typename P::message_indicator M>
+        void operator()
+        (
+            bcpp::message::message<P, M> const & message
+        )
+        {
+            sum_ += (message.value_ + static_cast<std::uint64_t>(M));
+        }
+
+        std::uint64_t sum_{0};
+    };
+
+
+    //=========================================================================
+    // measure draining a stream of which only 'subscribed' of the message types are delivered.  the stream
+    // is cut into packets of whole messages outside of the timed region.
+    template <bcpp::message::protocol_concept P>
+    result run_subscription_bench
+    (
+        std::string name,
+        std::vector<char> const & stream,
+        std::size_t messageCount,
+        std::size_t subscribed,
+        std::size_t iterations
+    )
+    {
+        using message_header = bcpp::message::message_header<P>;
+        static auto constexpr packet_capacity = (1 << 12);
+
+        typename subscription_target<P>::subscription_type subscriptions;
+        for (std::size_t i = 0; i < std::min(subscribed, P::message_arity); ++i)
+            subscriptions.insert(P::get(i));
+        subscription_target<P> target(subscriptions);
+
+        std::vector<std::vector<char>> packets;
+        for (auto current = stream.data(), end = stream.data() + stream.size(); current < end; )
+        {
+            auto packetEnd = current;
+            while ((packetEnd < end) && ((packetEnd - current) + reinterpret_cast<message_header const *>(packetEnd)->size() <= packet_capacity))
+                packetEnd += reinterpret_cast<message_header const *>(packetEnd)->size();
+            packets.emplace_back(current, packetEnd);
+            current = packetEnd;
+        }
+
+        std::chrono::nanoseconds elapsed{0};
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            for (auto const & packet : packets)
+                target << std::vector<char>(packet);
+            auto start = std::chrono::steady_clock::now();
+            target.process_all();
+            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        }
+        return {std::move(name), messageCount * iterations, elapsed, (target.sum_ == 0) ? "no messages" : ""};
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::protocol_concept P>
+    void dispatch_bench
+    (
+        std::string const & name,
+        result_set & results,
+        std::size_t messageCount,
+        std::size_t iterations
+    )
+    {
+        auto strategy = [](auto s) -> std::string
+                {
+                    switch (s)
+                    {
+                        case bcpp::message::dispatch_strategy::inline_switch: return "inline_switch";
+                        case bcpp::message::dispatch_strategy::dense_table: return "dense_table";
+                        case bcpp::message::dispatch_strategy::perfect_hash: return "perfect_hash";
+                        case bcpp::message::dispatch_strategy::binary_search: return "binary_search";
+                    }
+                    return "unknown";
+                }(bcpp::message::dispatcher<dispatch_target<P>, P>::strategy);
+
+        auto legacyName = ("dispatch/" + name + "/legacy_table");
+        auto dispatcherName = ("dispatch/" + name + "/" + strategy);
+        if ((!results.selected(legacyName)) && (!results.selected(dispatcherName)))
+            return;
+        auto stream = make_message_stream<P>(messageCount);
+        if constexpr (sizeof(typename P::message_indicator) <= sizeof(std::uint16_t))
+            results.run(legacyName, [&](std::string name){return run_dispatch_bench<table_dispatcher, P>(std::move(name), stream, iterations);});
+        results.run(dispatcherName, [&](std::string name){return run_dispatch_bench<bcpp::message::dispatcher, P>(std::move(name), stream, iterations);});
+    }
+
+
+    //=========================================================================
+    // every message type subscribed to versus a small subset of a wide protocol
+    template <bcpp::message::protocol_concept P>
+    void subscription_bench
+    (
+        std::string const & name,
+        result_set & results,
+        std::size_t messageCount,
+        std::size_t iterations
+    )
+    {
+        auto allName = ("subscription/" + name + "/all");
+        auto subsetName = ("subscription/" + name + "/2_of_" + std::to_string(P::message_arity));
+        if ((!results.selected(allName)) && (!results.selected(subsetName)))
+            return;
+        auto stream = make_message_stream<P>(messageCount);
+        results.run(allName, [&](std::string name){return run_subscription_bench<P>(std::move(name), stream, messageCount, P::message_arity, iterations);});
+        results.run(subsetName, [&](std::string name){return run_subscription_bench<P>(std::move(name), stream, messageCount, 2, iterations);});
+    }
+
+} // namespace bench
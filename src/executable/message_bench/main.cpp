@@ -0,0 +1,98 @@
+#include "./concurrent_bench.h"
+#include "./dispatch_bench.h"
+#include "./transport_bench.h"
+#include "./report.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+
+    //=========================================================================
+    void usage
+    (
+        char const * name
+    )
+    {
+        std::cerr << "usage: " << name << " [--format table|json|csv] [--iterations N] [--filter substring]\n";
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int argc,
+    char ** argv
+)
+{
+    static auto constexpr message_count = (1 << 16);
+
+    auto format = bench::report_format::table;
+    std::size_t iterations = 64;
+    std::string filter;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg(argv[i]);
+        if ((arg == "--format") && ((i + 1) < argc))
+        {
+            std::string_view value(argv[++i]);
+            if (value == "json")
+                format = bench::report_format::json;
+            else if (value == "csv")
+                format = bench::report_format::csv;
+            else if (value != "table")
+                return usage(argv[0]), 1;
+        }
+        else if ((arg == "--iterations") && ((i + 1) < argc))
+        {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+            if (iterations == 0)
+                return usage(argv[0]), 1;
+        }
+        else if ((arg == "--filter") && ((i + 1) < argc))
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            return usage(argv[0]), 1;
+        }
+    }
+
+    bench::result_set results(filter);
+
+    // compare the original dispatch table with the compile time dispatch engine
+    bench::dispatch_bench<bench::make_protocol<std::uint8_t, 8, 1, 1>>("8_contiguous_uint8", results, message_count, iterations);
+    bench::dispatch_bench<bench::make_protocol<std::uint8_t, 64, 1, 1>>("64_contiguous_uint8", results, message_count, iterations);
+    bench::dispatch_bench<bench::make_protocol<std::uint16_t, 8, 1, 1000>>("8_contiguous_uint16", results, message_count, iterations);
+    bench::dispatch_bench<bench::make_protocol<std::uint16_t, 64, 1021, 7>>("64_sparse_uint16", results, message_count, iterations);
+    bench::dispatch_bench<bench::make_protocol<std::uint32_t, 64, 0x9e3779b1, 11>>("64_sparse_uint32", results, message_count, iterations);
+
+    // cost of skipping the message types which a receiver does not subscribe to
+    bench::subscription_bench<bench::make_protocol<std::uint8_t, 200, 1, 1>>("200_contiguous_uint8", results, message_count, iterations);
+    bench::subscription_bench<bench::make_protocol<std::uint32_t, 64, 0x9e3779b1, 11>>("64_sparse_uint32", results, message_count, iterations);
+
+    // transmit and receive paths for each packet type and message size.  the transport cases move far
+    // more data per iteration than the dispatch cases so they run fewer iterations.
+    auto transportIterations = std::max<std::size_t>(iterations / 16, 1);
+    bench::transport_bench<std::vector<char>>(results, transportIterations);
+    bench::transport_bench<bcpp::message::aligned_packet>(results, transportIterations);
+    bench::replay_bench(results, transportIterations);
+
+    // many threads publishing onto one connection
+    bench::concurrent_transmit_bench(results, transportIterations);
+
+    bench::report(results.get_results(), format);
+    for (auto const & result : results.get_results())
+        if (result.failed())
+            std::cerr << result.name_ << " failed: " << result.failure_ << '\n';
+    return (results.any_failed() ? 1 : 0);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace bench
+{
+
+    struct result
+    {
+        std::string                 name_;
+        std::size_t                 messages_;
+        std::chrono::nanoseconds    elapsed_;
+        std::string                 failure_{};     // why the case failed (empty if it succeeded)
+
+        bool failed() const{return (!failure_.empty());}
+
+        double nanoseconds_per_message() const
+        {
+            return (messages_ == 0) ? 0.0 : (static_cast<double>(elapsed_.count()) / messages_);
+        }
+
+        double messages_per_second() const
+        {
+            return (elapsed_.count() == 0) ? 0.0 : ((messages_ * 1'000'000'000.0) / elapsed_.count());
+        }
+    };
+
+
+    //=========================================================================
+    // the results of the cases selected by the filter (a substring of the case name).  cases which are not
+    // selected are never run.
+    class result_set
+    {
+    public:
+
+        explicit result_set
+        (
+            std::string filter
+        ):
+            filter_(std::move(filter))
+        {
+        }
+
+        bool selected
+        (
+            std::string const & name
+        ) const
+        {
+            return (filter_.empty() || (name.find(filter_) != std::string::npos));
+        }
+
+        // runCase(name) is called (and its result kept) only if the case is selected
+        template <typename F>
+        void run
+        (
+            std::string name,
+            F && runCase
+        )
+        {
+            if (selected(name))
+                results_.push_back(runCase(std::move(name)));
+        }
+
+        std::vector<result> const & get_results() const{return results_;}
+
+        bool any_failed() const
+        {
+            return std::any_of(results_.begin(), results_.end(), [](auto const & result){return result.failed();});
+        }
+
+    private:
+
+        std::string         filter_;
+
+        std::vector<result> results_;
+
+    }; // class result_set
+
+
+    // table is for humans.  json and csv are for tooling which compares runs.
+    enum class report_format
+    {
+        table,
+        json,
+        csv
+    };
+
+
+    //=========================================================================
+    inline void report
+    (
+        std::vector<result> const & results,
+        report_format format = report_format::table,
+        std::ostream & stream = std::cout
+    )
+    {
+        switch (format)
+        {
+            case report_format::table:
+            {
+                for (auto const & result : results)
+                    stream << std::left << std::setw(64) << result.name_ << std::right << std::fixed << std::setprecision(2) << 
+                            std::setw(10) << result.nanoseconds_per_message() << " ns/msg" << 
+                            std::setw(16) << std::setprecision(0) << result.messages_per_second() << " msg/sec" << 
+                            (result.failed() ? ("  FAILED: " + result.failure_) : "") << '\n';
+                break;
+            }
+            case report_format::json:
+            {
+                // names and failures are generated by the benchmarks and never require escaping
+                stream << "[\n" << std::fixed;
+                for (std::size_t i = 0; i < results.size(); ++i)
+                    stream << "  {\"name\": \"" << results[i].name_ << "\", \"messages\": " << results[i].messages_ << 
+                            ", \"elapsed_ns\": " << results[i].elapsed_.count() << 
+                            ", \"ns_per_message\": " << std::setprecision(3) << results[i].nanoseconds_per_message() << 
+                            ", \"messages_per_second\": " << std::setprecision(0) << results[i].messages_per_second() << 
+                            ", \"failure\": \"" << results[i].failure_ << "\"}" << (((i + 1) < results.size()) ? ",\n" : "\n");
+                stream << "]\n";
+                break;
+            }
+            case report_format::csv:
+            {
+                stream << "name,messages,elapsed_ns,ns_per_message,messages_per_second,failure\n" << std::fixed;
+                for (auto const & result : results)
+                    stream << result.name_ << ',' << result.messages_ << ',' << result.elapsed_.count() << ',' << 
+                            std::setprecision(3) << result.nanoseconds_per_message() << ',' << 
+                            std::setprecision(0) << result.messages_per_second() << ',' << result.failure_ << '\n';
+                break;
+            }
+        }
+    }
+
+} // namespace bench
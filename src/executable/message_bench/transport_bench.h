@@ -0,0 +1,298 @@
+#pragma once
+
+#include "./bench_protocol.h"
+#include "./report.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <queue>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace bench
+{
+
+    //=========================================================================
+    template <bcpp::message::packet_concept P>
+    std::string packet_name()
+    {
+        if constexpr (std::is_same_v<P, std::vector<char>>)
+            return "vector";
+        else if constexpr (std::is_same_v<P, bcpp::message::aligned_packet>)
+            return "aligned_packet";
+        else
+            return "packet";
+    }
+
+
+    //=========================================================================
+    template <payload_size S>
+    std::string payload_name()
+    {
+        if constexpr (S == payload_size::small)
+            return "small";
+        else if constexpr (S == payload_size::medium)
+            return "medium";
+        else
+            return "max";
+    }
+
+
+    //=========================================================================
+    // measure transmitter::send (construct then copy) or transmitter::emplace (construct in place).
+    // flushed packets are recycled back to the transmitter so that packet allocation is not measured.
+    template <bcpp::message::packet_concept P, payload_size S, bool emplace>
+    result run_transmit_bench
+    (
+        std::string name,
+        std::size_t messageCount,
+        std::size_t iterations
+    )
+    {
+        using message = bcpp::message::message<payload_protocol, S>;
+
+        P spare;
+        std::size_t bytesFlushed = 0;
+        auto transmitter = bcpp::message::make_transmitter<payload_protocol, P>({},
+                [&](auto const &, std::size_t capacity)
+                {
+                    P packet = std::move(spare);
+                    packet.clear();
+                    packet.reserve(capacity);
+                    return packet;
+                },
+                [&](auto const &, P packet)
+                {
+                    bytesFlushed += packet.size();
+                    spare = std::move(packet);
+                });
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            for (std::size_t j = 0; j < messageCount; ++j)
+            {
+                if constexpr (emplace)
+                    transmitter.template emplace<message>(j);
+                else
+                    transmitter.send(message(j));
+            }
+        }
+        transmitter.flush();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return {std::move(name), messageCount * iterations, elapsed, (bytesFlushed != (messageCount * iterations * sizeof(message))) ? "lost messages" : ""};
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::packet_concept P>
+    struct receive_target :
+        bcpp::message::receiver<receive_target<P>, payload_protocol, std::queue<P>>
+    {
+        receive_target():bcpp::message::receiver<receive_target<P>, payload_protocol, std::queue<P>>({}, {}){}
+
+        template <payload_size S>
+        void operator()
+        (
+            bcpp::message::message<payload_protocol, S> const & message
+        )
+        {
+            sum_ += message.value_;
+            ++messages_;
+        }
+
+        std::uint64_t   sum_{0};
+        std::size_t     messages_{0};
+    };
+
+
+    //=========================================================================
+    // as receive_target but receives runs of messages via the receiver's batch handler support
+    template <bcpp::message::packet_concept P>
+    struct batch_receive_target :
+        bcpp::message::receiver<batch_receive_target<P>, payload_protocol, std::queue<P>>
+    {
+        batch_receive_target():bcpp::message::receiver<batch_receive_target<P>, payload_protocol, std::queue<P>>({}, {}){}
+
+        template <payload_size S>
+        void operator()
+        (
+            std::span<bcpp::message::message<payload_protocol, S> const> messages
+        )
+        {
+            for (auto const & message : messages)
+                sum_ += message.value_;
+            messages_ += messages.size();
+        }
+
+        std::uint64_t   sum_{0};
+        std::size_t     messages_{0};
+    };
+
+
+    //=========================================================================
+    // split a stream of messages into packets.  a fragment size of zero packs as many whole messages as
+    // fit into each default sized packet (the aligned case).  any other fragment size cuts the stream every
+    // 'fragmentSize' bytes regardless of message boundaries (the straddled case).
+    template <bcpp::message::packet_concept P, payload_size S>
+    std::vector<P> make_packets
+    (
+        std::size_t messageCount,
+        std::size_t fragmentSize
+    )
+    {
+        using message = bcpp::message::message<payload_protocol, S>;
+
+        std::vector<char> stream;
+        stream.reserve(messageCount * sizeof(message));
+        for (std::size_t i = 0; i < messageCount; ++i)
+        {
+            message m(i);
+            stream.insert(stream.end(), reinterpret_cast<char const *>(&m), reinterpret_cast<char const *>(&m) + sizeof(m));
+        }
+
+        if (fragmentSize == 0)
+        {
+            static auto constexpr packet_capacity = bcpp::message::transmitter<payload_protocol, P>::default_packet_capacity;
+            fragmentSize = ((packet_capacity / sizeof(message)) * sizeof(message));
+        }
+
+        std::vector<P> packets;
+        packets.reserve((stream.size() + fragmentSize - 1) / fragmentSize);
+        for (std::size_t offset = 0; offset < stream.size(); offset += fragmentSize)
+        {
+            auto size = std::min(fragmentSize, stream.size() - offset);
+            P packet;
+            packet.reserve(size);
+            packet.resize(size);
+            std::copy_n(stream.data() + offset, size, packet.data());
+            packets.push_back(std::move(packet));
+        }
+        return packets;
+    }
+
+
+    //=========================================================================
+    // measure the receive path.  packets are copied into the receiver outside of the timed region.
+    template <bcpp::message::packet_concept P, payload_size S, bool drain, typename R = receive_target<P>>
+    result run_receive_bench
+    (
+        std::string name,
+        std::size_t messageCount,
+        std::size_t fragmentSize,
+        std::size_t iterations
+    )
+    {
+        auto packets = make_packets<P, S>(messageCount, fragmentSize);
+
+        R target;
+        std::chrono::nanoseconds elapsed{0};
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            for (auto const & packet : packets)
+                target << P(packet);
+            auto start = std::chrono::steady_clock::now();
+            if constexpr (drain)
+                target.process_all();
+            else
+                while (target.process_next_message())
+                    ;
+            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        }
+        return {std::move(name), messageCount * iterations, elapsed, (target.messages_ != (messageCount * iterations)) ? "lost messages" : ""};
+    }
+
+
+    //=========================================================================
+    // capture the aligned packet stream to a journal and measure replaying it (as fast as possible) 
+    // directly out of the memory mapped journal
+    template <payload_size S>
+    result run_replay_bench
+    (
+        std::string name,
+        std::size_t messageCount,
+        std::size_t iterations
+    )
+    {
+        auto directory = (std::filesystem::temp_directory_path() / "message_bench_journal");
+        std::filesystem::create_directories(directory);
+        {
+            bcpp::message::journal_writer journalWriter({.directory_ = directory.string(), .name_ = payload_name<S>()});
+            for (auto const & packet : make_packets<std::vector<char>, S>(messageCount, 0))
+                journalWriter.append(packet);
+        }
+
+        receive_target<bcpp::message::packet_view> target;
+        std::chrono::nanoseconds elapsed{0};
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            bcpp::message::journal_reader journalReader({.directory_ = directory.string(), .name_ = payload_name<S>()});
+            elapsed += journalReader.replay(target).elapsed_;
+        }
+        std::filesystem::remove_all(directory);
+        return {std::move(name), messageCount * iterations, elapsed, (target.messages_ != (messageCount * iterations)) ? "lost messages" : ""};
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::packet_concept P, payload_size S>
+    void transport_bench
+    (
+        result_set & results,
+        std::size_t iterations
+    )
+    {
+        // keep the volume of data per case roughly constant regardless of message size
+        static auto constexpr aligned_bytes = (1 << 23);
+        static auto constexpr straddled_bytes = (1 << 20);
+        static auto constexpr message_size = payload_message_size<S>;
+        static auto constexpr fragment_sizes = std::array<std::size_t, 4>{1, 7, 61, 509};
+
+        auto suffix = "/" + packet_name<P>() + "/" + payload_name<S>();
+        results.run("send" + suffix, [&](std::string name){return run_transmit_bench<P, S, false>(std::move(name), aligned_bytes / message_size, iterations);});
+        results.run("emplace" + suffix, [&](std::string name){return run_transmit_bench<P, S, true>(std::move(name), aligned_bytes / message_size, iterations);});
+        results.run("process_next_message/aligned" + suffix, [&](std::string name){return run_receive_bench<P, S, false>(std::move(name), aligned_bytes / message_size, 0, iterations);});
+        results.run("process_all/aligned" + suffix, [&](std::string name){return run_receive_bench<P, S, true>(std::move(name), aligned_bytes / message_size, 0, iterations);});
+        results.run("process_all/aligned_batch" + suffix, [&](std::string name){return run_receive_bench<P, S, true, batch_receive_target<P>>(std::move(name), aligned_bytes / message_size, 0, iterations);});
+        for (std::size_t fragmentSize : fragment_sizes)
+            results.run("process_next_message/straddled_" + std::to_string(fragmentSize) + suffix, [&](std::string name)
+                    {
+                        return run_receive_bench<P, S, false>(std::move(name), straddled_bytes / message_size, fragmentSize, iterations);
+                    });
+    }
+
+
+    //=========================================================================
+    template <bcpp::message::packet_concept P>
+    void transport_bench
+    (
+        result_set & results,
+        std::size_t iterations
+    )
+    {
+        transport_bench<P, payload_size::small>(results, iterations);
+        transport_bench<P, payload_size::medium>(results, iterations);
+        transport_bench<P, payload_size::max>(results, iterations);
+    }
+
+
+    //=========================================================================
+    inline void replay_bench
+    (
+        result_set & results,
+        std::size_t iterations
+    )
+    {
+        static auto constexpr journal_bytes = (1 << 23);
+        results.run("replay/journal/small", [&](std::string name){return run_replay_bench<payload_size::small>(std::move(name), journal_bytes / payload_message_size<payload_size::small>, iterations);});
+        results.run("replay/journal/medium", [&](std::string name){return run_replay_bench<payload_size::medium>(std::move(name), journal_bytes / payload_message_size<payload_size::medium>, iterations);});
+        results.run("replay/journal/max", [&](std::string name){return run_replay_bench<payload_size::max>(std::move(name), journal_bytes / payload_message_size<payload_size::max>, iterations);});
+    }
+
+} // namespace bench
@@ -1,12 +1,14 @@
 #include "./my_protocol.h"
 
 #include <library/network.h>
+#include <library/work_contract.h>
 
 #include <array>
 #include <string>
 #include <iostream>
 #include <atomic>
 #include <memory>
+#include <thread>
 
 // a flag used to indicate that the message has been received
 std::atomic<bool> done{false};
@@ -27,7 +29,7 @@ class message_recipient :
 {
 public:
 
-    message_recipient():receiver({}, {}){}
+    message_recipient(event_handlers eventHandlers):receiver({}, eventHandlers){}
     
 private:
 
@@ -39,8 +41,23 @@ private:
         login_request_message const & loginRequestMessage
     )
     {
-        std::cout << "Got login request.  account = " << std::string_view(loginRequestMessage.account_.data(), loginRequestMessage.account_.size()) << 
-                ", password = " << std::string_view(loginRequestMessage.password_.data(), loginRequestMessage.password_.size()) << '\n';
+        std::cout << "Got login request.  account = " << loginRequestMessage.get<"account">() << 
+                ", password = " << loginRequestMessage.get<"password">() << '\n';
+        return *this;
+    }
+
+    auto & operator()
+    (
+        // a message callback used when receiving price_update_messages
+        price_update_message const & priceUpdateMessage
+    )
+    {
+        auto prices = priceUpdateMessage.get<"prices">();
+        std::cout << "Got price update.  instrument = " << priceUpdateMessage.get<"instrument_id">() << 
+                ", sequence = " << priceUpdateMessage.get<"sequence">() << ", prices =";
+        for (std::size_t i = 0; i < prices.size(); ++i)
+            std::cout << ' ' << prices[i];
+        std::cout << '\n';
         return *this;
     }
 
@@ -57,6 +74,45 @@ private:
 };
 
 
+//=============================================================================
+// the same recipient serviced by a thread pool.  packets are pushed from the sending thread and each push
+// schedules the recipient's work contract.
+class scheduled_message_recipient : 
+    public bcpp::message::receiver<scheduled_message_recipient, my_protocol, bcpp::message::mpsc_packet_queue<packet_type>>
+{
+public:
+
+    scheduled_message_recipient():receiver({}, {}, packet_queue_capacity){}
+
+    bool is_done() const{return done_;}
+
+private:
+
+    static auto constexpr packet_queue_capacity = 64;
+
+    friend class receiver;
+
+    void operator()
+    (
+        login_request_message const & loginRequestMessage
+    )
+    {
+        std::cout << "Got scheduled login request.  account = " << loginRequestMessage.get<"account">() << '\n';
+    }
+
+    void operator()
+    (
+        login_response_message const &
+    )
+    {
+        std::cout << "Got scheduled login response message\n";
+        done_ = true;
+    }
+
+    std::atomic<bool> done_{false};
+};
+
+
 //=============================================================================
 int main
 (
@@ -64,14 +120,12 @@ int main
     char **
 )
 {
-    message_recipient messageRecipient;
+    // consumed packets are returned to the pool by the recipient and reused by the sender
+    bcpp::message::packet_pool<packet_type> packetPool({});
+
+    message_recipient messageRecipient({.packetDiscardHandler_ = packetPool.get_packet_discard_handler()});
     message_sender messageSender({}, {
-            .packetAllocateHandler_ = [](auto const & sender, auto size)
-                    {
-                        packet_type packet;
-                        packet.reserve(size);
-                        return packet;
-                    }, 
+            .packetAllocateHandler_ = packetPool.get_packet_allocate_handler(), 
             .packetHandler_ = [&](auto const &, auto packet)
                     {
                         messageRecipient << std::move(packet);
@@ -79,6 +133,8 @@ int main
 
     // create a login request message in a 'packet'
     messageSender.send(login_request_message("my_account", "my_password"));
+    // constructed in place, including its variable length tail of prices
+    messageSender.emplace<price_update_message>(std::uint32_t(42), std::uint64_t(1), std::array<std::int64_t, 3>{10025, 10050, 10075});
     messageSender.emplace<login_response_message>(login_response_message::response_code::success);
 
     messageSender.flush();
@@ -86,6 +142,26 @@ int main
     // loop until the message recipient class has acked the message that we just sent
     while (!done)
         messageRecipient.process_next_message();
-  
+
+    // the same exchange with the recipient serviced by a pool of threads via a work contract
+    bcpp::work_contract_group workContractGroup(16);
+    scheduled_message_recipient scheduledMessageRecipient;
+    bcpp::message::receiver_contract<scheduled_message_recipient, bcpp::work_contract_group> receiverContract({}, scheduledMessageRecipient, workContractGroup);
+    bcpp::message::receiver_thread_pool<bcpp::work_contract_group> receiverThreadPool({.threadCount_ = 1, .cpus_ = {0}}, workContractGroup,
+            {.pinFailureHandler_ = [](auto threadIndex, auto cpu){std::cerr << "failed to pin thread " << threadIndex << " to cpu " << cpu << '\n';}});
+
+    message_sender scheduledMessageSender({}, {
+            .packetHandler_ = [&](auto const &, auto packet)
+                    {
+                        receiverContract << std::move(packet);
+                    }});
+    scheduledMessageSender.send(login_request_message("my_account", "my_password"));
+    scheduledMessageSender.emplace<login_response_message>(login_response_message::response_code::success);
+    scheduledMessageSender.flush();
+
+    while (!scheduledMessageRecipient.is_done())
+        std::this_thread::yield();
+    receiverThreadPool.stop();
+
     return 0;
 }
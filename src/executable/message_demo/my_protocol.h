@@ -12,7 +12,8 @@
 enum class my_message_indicator : std::uint8_t
 {
     login_request = 1,
-    login_response = 2
+    login_response = 2,
+    price_update = 3
 };
 
 
@@ -22,7 +23,8 @@ using my_protocol = bcpp::message::protocol
         <
             bcpp::message::protocol_traits<"my_protocol_name", {1, 0, 'a'}, my_message_indicator>, 
             my_message_indicator::login_request,
-            my_message_indicator::login_response
+            my_message_indicator::login_response,
+            my_message_indicator::price_update
         >;
 
 
@@ -39,6 +41,7 @@ namespace bcpp::message
         message_header(my_message_indicator messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
         auto get_message_indicator() const{return messageIndicator_;}
         auto size() const{return size_;}
+        void set_size(std::uint16_t size){size_ = size;} // used by transmitter::commit()
         my_message_indicator messageIndicator_;
         std::uint16_t        size_;
     };
@@ -46,55 +49,66 @@ namespace bcpp::message
 
 
     //=========================================================================
-    // specialize a login request message
-    // for demonstration purposes add payload methods
-    #pragma pack(push, 1)
+    // specialize a login request message.  the layout generates a packed message with string fields
+    // which are read and written by name (loginRequestMessage.get<"account">()).
     template <>
     struct message<my_protocol, my_message_indicator::login_request> :
-        message_header<my_protocol>
+        message_layout
+        <
+            my_protocol, 
+            my_message_indicator::login_request,
+            field<"account", std::array<char, 32>>,
+            field<"password", std::array<char, 32>>
+        >
     {
-        static auto constexpr type = my_message_indicator::login_request;
-        message():message_header(type, sizeof(*this)){};
-        message(std::string_view const account, std::string_view const password):message_header(type, sizeof(*this))
-        {
-            std::copy_n(account.data(), std::min(account.size(), account_.size()), account_.data());
-            std::copy_n(password.data(), std::min(password.size(), password_.size()), password_.data());
-        }
-        std::array<char, 32> account_{};
-        std::array<char, 32> password_{};
+        using message_layout::message_layout;
     };
-    #pragma pack(pop)
 
 
     //=========================================================================
     // specialize a login response message
-    #pragma pack(push)
+    enum class login_response_code : std::uint8_t
+    {
+        undefined = 0,
+        success = 1,
+        invalid_account = 2,
+        invalid_password = 3
+    };
+
     template <>
     struct message<my_protocol, my_message_indicator::login_response> :
-        message_header<my_protocol>
+        message_layout
+        <
+            my_protocol, 
+            my_message_indicator::login_response,
+            field<"response_code", login_response_code>
+        >
     {
-        static auto constexpr type = my_message_indicator::login_response;
-        
-        enum class response_code : std::uint8_t
-        {
-            undefined = 0,
-            success = 1,
-            invalid_account = 2,
-            invalid_password = 3
-        };
-
-        message():message_header(type, sizeof(*this)){}
-
-        static constexpr auto size(){return sizeof(message);} // fixed sized message
+        using response_code = login_response_code;
+        using message_layout::message_layout;
+    };
 
-        message(response_code responseCode):message_header(type, sizeof(*this)), responseCode_(responseCode){}
 
-        response_code responseCode_;
+    //=========================================================================
+    // specialize a price update message.  the fixed fields are held in network byte order and the
+    // variable number of prices follow as a tail array (sized by the arguments given to emplace).
+    template <>
+    struct message<my_protocol, my_message_indicator::price_update> :
+        message_layout
+        <
+            my_protocol, 
+            my_message_indicator::price_update,
+            big_endian_field<"instrument_id", std::uint32_t>,
+            big_endian_field<"sequence", std::uint64_t>,
+            tail_field<"prices", std::int64_t, std::endian::big>
+        >
+    {
+        using message_layout::message_layout;
     };
-    #pragma pack(pop)
 
 } // namespace bcpp::message
 
 
 using login_request_message = bcpp::message::message<my_protocol, my_message_indicator::login_request>;
 using login_response_message = bcpp::message::message<my_protocol, my_message_indicator::login_response>;
+using price_update_message = bcpp::message::message<my_protocol, my_message_indicator::price_update>;
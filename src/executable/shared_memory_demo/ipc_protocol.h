@@ -0,0 +1,53 @@
+#pragma once
+
+#include <library/message.h>
+
+#include <cstdint>
+
+
+enum class ipc_message_indicator : std::uint8_t
+{
+    tick = 1
+};
+
+
+using ipc_protocol = bcpp::message::protocol
+        <
+            bcpp::message::protocol_traits<"ipc_protocol", {1, 0, 'a'}, ipc_message_indicator>, 
+            ipc_message_indicator::tick
+        >;
+
+
+namespace bcpp::message
+{
+
+    #pragma pack(push, 1)
+    template <>
+    struct message_header<ipc_protocol>
+    {
+        using protocol = ipc_protocol;
+        message_header(ipc_message_indicator messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        ipc_message_indicator   messageIndicator_;
+        std::uint16_t           size_;
+    };
+
+
+    // a sequenced message stamped with the (steady clock) time at which it was sent
+    template <>
+    struct message<ipc_protocol, ipc_message_indicator::tick> :
+        message_header<ipc_protocol>
+    {
+        static auto constexpr type = ipc_message_indicator::tick;
+        message(std::uint64_t sequence, std::uint64_t sendTime):message_header(type, sizeof(*this)), sequence_(sequence), sendTime_(sendTime){}
+        static constexpr auto size(std::uint64_t, std::uint64_t){return sizeof(message);}
+        std::uint64_t   sequence_;
+        std::uint64_t   sendTime_;
+    };
+    #pragma pack(pop)
+
+} // namespace bcpp::message
+
+
+using tick_message = bcpp::message::message<ipc_protocol, ipc_message_indicator::tick>;
@@ -0,0 +1,137 @@
+#include "./ipc_protocol.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <string>
+
+
+namespace
+{
+
+    auto constexpr ring_name = "/bcpp_message_shared_memory_demo";
+    auto constexpr message_count = std::uint64_t(10'000'000);
+
+    using packet_type = bcpp::message::packet_view;
+
+
+    //=========================================================================
+    std::uint64_t now
+    (
+    )
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+
+    //=========================================================================
+    // dispatches messages directly out of the shared memory mapping
+    class tick_recipient : 
+        public bcpp::message::receiver<tick_recipient, ipc_protocol, std::queue<packet_type>>
+    {
+    public:
+
+        tick_recipient(event_handlers eventHandlers):receiver({}, eventHandlers){}
+
+        std::uint64_t get_messages_received() const{return messagesReceived_;}
+
+        std::uint64_t get_sequence_errors() const{return sequenceErrors_;}
+
+        std::uint64_t get_total_latency() const{return totalLatency_;}
+
+    private:
+
+        friend class receiver;
+
+        void operator()
+        (
+            tick_message const & tickMessage
+        )
+        {
+            sequenceErrors_ += (tickMessage.sequence_ != messagesReceived_);
+            totalLatency_ += (now() - tickMessage.sendTime_);
+            ++messagesReceived_;
+        }
+
+        std::uint64_t   messagesReceived_{0};
+        std::uint64_t   sequenceErrors_{0};
+        std::uint64_t   totalLatency_{0};
+    };
+
+
+    //=========================================================================
+    int run_receiver
+    (
+    )
+    {
+        // open the ring created by the parent process
+        bcpp::message::shared_memory_ring ring({.name_ = ring_name, .openMode_ = bcpp::message::shared_memory_ring::open_mode::open});
+        if (!ring.is_valid())
+        {
+            std::cerr << "receiver: failed to open " << ring_name << '\n';
+            return 1;
+        }
+
+        tick_recipient recipient({ring.get_packet_discard_handler()});
+        auto start = std::chrono::steady_clock::now();
+        while (!ring.is_closed())
+        {
+            if (auto packet = ring.wait(std::chrono::milliseconds(1)); !packet.empty())
+                recipient << std::move(packet);
+            recipient.process_all();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        auto messagesReceived = recipient.get_messages_received();
+        std::cout << "receiver: " << messagesReceived << " messages in " << elapsed.count() << " sec (" << 
+                (messagesReceived / elapsed.count()) << " msg/sec), mean latency = " << 
+                (recipient.get_total_latency() / std::max<std::uint64_t>(messagesReceived, 1)) << " ns, sequence errors = " << 
+                recipient.get_sequence_errors() << '\n';
+        return ((messagesReceived == message_count) && (recipient.get_sequence_errors() == 0)) ? 0 : 1;
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    // the producer creates the ring before the consumer process starts
+    bcpp::message::shared_memory_ring ring({.name_ = ring_name, .openMode_ = bcpp::message::shared_memory_ring::open_mode::create, .capacity_ = (1 << 22)});
+    if (!ring.is_valid())
+    {
+        std::cerr << "transmitter: failed to create " << ring_name << '\n';
+        return 1;
+    }
+
+    auto pid = ::fork();
+    if (pid == -1)
+        return 1;
+    if (pid == 0)
+        return run_receiver();
+
+    {
+        // serialize directly into the shared memory mapping
+        auto transmitter = bcpp::message::make_transmitter<ipc_protocol, packet_type>({.packetCapacity_ = (1 << 12), .flushPolicy_ = {.maxAge_ = std::chrono::microseconds(10)}},
+                ring.get_packet_allocate_handler(), ring.get_packet_handler());
+        for (std::uint64_t i = 0; i < message_count; ++i)
+        {
+            transmitter.emplace<tick_message>(i, now());
+            transmitter.poll();
+        }
+        transmitter.flush();
+    }
+    ring.close();
+
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    return (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
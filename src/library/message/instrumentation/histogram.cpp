@@ -0,0 +1,70 @@
+#include "./histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//=============================================================================
+std::uint64_t bcpp::message::histogram::to_upper_bound
+(
+    std::size_t index
+)
+{
+    if (index < sub_bucket_count)
+        return index;
+    auto magnitude = ((index / sub_bucket_count) + sub_bucket_bits - 1);
+    auto subBucket = (index % sub_bucket_count);
+    auto lowerBound = ((sub_bucket_count + subBucket) << (magnitude - sub_bucket_bits));
+    return (lowerBound + ((std::uint64_t(1) << (magnitude - sub_bucket_bits)) - 1));
+}
+
+
+//=============================================================================
+void bcpp::message::histogram::merge
+(
+    histogram const & other
+)
+{
+    for (std::size_t i = 0; i < bucket_count; ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+
+//=============================================================================
+void bcpp::message::histogram::clear
+(
+)
+{
+    *this = histogram();
+}
+
+
+//=============================================================================
+double bcpp::message::histogram::mean
+(
+) const
+{
+    return (count_ == 0) ? 0.0 : (static_cast<double>(sum_) / count_);
+}
+
+
+//=============================================================================
+std::uint64_t bcpp::message::histogram::percentile
+(
+    double percentile
+) const
+{
+    if (count_ == 0)
+        return 0;
+    auto target = static_cast<std::uint64_t>(std::ceil((std::clamp(percentile, 0.0, 100.0) / 100.0) * count_));
+    target = std::max<std::uint64_t>(target, 1);
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i)
+        if ((total += counts_[i]) >= target)
+            return std::min(to_upper_bound(i), max_);
+    return max_;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // fixed size log-linear histogram (in the spirit of HDR histogram).  values below sub_bucket_count are
+    // recorded exactly.  larger values are recorded in one of sub_bucket_count linear buckets within their
+    // power of two which bounds the relative error to 1 / sub_bucket_count.  the histogram is a plain value
+    // type so that it can be copied into a snapshot and merged with others.
+    class histogram
+    {
+    public:
+
+        static auto constexpr sub_bucket_bits = 3;
+        static auto constexpr sub_bucket_count = (1 << sub_bucket_bits);
+        static auto constexpr bucket_count = ((64 - sub_bucket_bits + 1) * sub_bucket_count);
+
+        void record
+        (
+            std::uint64_t
+        );
+
+        void merge
+        (
+            histogram const &
+        );
+
+        void clear();
+
+        std::uint64_t count() const{return count_;}
+
+        std::uint64_t min() const{return (count_ == 0) ? 0 : min_;}
+
+        std::uint64_t max() const{return max_;}
+
+        double mean() const;
+
+        // the (upper bound of the bucket holding the) value below which 'percentile' percent of the values fall
+        std::uint64_t percentile
+        (
+            double
+        ) const;
+
+    private:
+
+        static std::size_t to_index
+        (
+            std::uint64_t
+        );
+
+        static std::uint64_t to_upper_bound
+        (
+            std::size_t
+        );
+
+        std::array<std::uint64_t, bucket_count>     counts_{};
+
+        std::uint64_t                               count_{0};
+
+        std::uint64_t                               sum_{0};
+
+        std::uint64_t                               min_{std::numeric_limits<std::uint64_t>::max()};
+
+        std::uint64_t                               max_{0};
+
+    }; // class histogram
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+inline std::size_t bcpp::message::histogram::to_index
+(
+    std::uint64_t value
+)
+{
+    if (value < sub_bucket_count)
+        return value;
+    std::size_t magnitude = (std::bit_width(value) - 1);
+    auto subBucket = ((value >> (magnitude - sub_bucket_bits)) & (sub_bucket_count - 1));
+    return (((magnitude - sub_bucket_bits + 1) * sub_bucket_count) + subBucket);
+}
+
+
+//=============================================================================
+inline void bcpp::message::histogram::record
+(
+    std::uint64_t value
+)
+{
+    ++counts_[to_index(value)];
+    ++count_;
+    sum_ += value;
+    if (value < min_)
+        min_ = value;
+    if (value > max_)
+        max_ = value;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "./histogram.h"
+
+#include <cstddef>
+
+
+namespace bcpp::message
+{
+
+    // instrumentation of the transmitter and receiver hot paths is compiled in only when the library is 
+    // configured with MESSAGE_ENABLE_INSTRUMENTATION (which defines BCPP_MESSAGE_INSTRUMENTATION).  when
+    // disabled the statistics members are empty and every update is discarded at compile time.
+    #ifdef BCPP_MESSAGE_INSTRUMENTATION
+    static auto constexpr instrumentation_enabled = true;
+    #else
+    static auto constexpr instrumentation_enabled = false;
+    #endif
+
+    // placeholder for statistics members when instrumentation is disabled
+    struct no_statistics{};
+
+    // one of every 'handler_sample_interval' messages (per message type) has its handler timed
+    static auto constexpr handler_sample_interval = 64;
+
+} // namespace bcpp::message
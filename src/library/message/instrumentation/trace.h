@@ -0,0 +1,43 @@
+#pragma once
+
+#include "./histogram.h"
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // when packet tracing is enabled (configuration::tracePackets_ on both the transmitter and the receiver)
+    // every packet begins with a packet_trace.  the timestamps are steady clock nanoseconds which on linux
+    // is CLOCK_MONOTONIC and therefore comparable across processes on the same host (shared memory or 
+    // loopback links) as well as across threads.
+    struct packet_trace
+    {
+        std::uint64_t   bufferedTime_;  // first message buffered in the packet
+        std::uint64_t   flushedTime_;   // packet handed to the packet handler
+    };
+
+
+    //=========================================================================
+    // latency by stage as recorded by the receiver (nanoseconds)
+    struct trace_statistics
+    {
+        histogram       parked_;        // first message buffered to packet flushed (time in a partially filled packet)
+        histogram       transit_;       // packet flushed to first read by the receiver (packet queue and link)
+        histogram       reassembly_;    // first byte of a straddled message read to its dispatch
+        histogram       endToEnd_;      // first message buffered to packet first read by the receiver
+    };
+
+
+    //=========================================================================
+    inline std::uint64_t trace_time
+    (
+    )
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+} // namespace bcpp::message
@@ -16,6 +16,10 @@ namespace bcpp::message
     template <protocol_concept T0>
     struct message_header;
 
+    // when used as a handler template argument of transmitter or receiver, selects the std::function
+    // based (runtime assignable) event handlers.  any other type is bound statically.
+    struct type_erased_handler{};
+
     template <typename T>
     concept message_concept = (std::is_same_v<T, message<typename T::protocol, T::type>> &&
         std::is_trivially_copyable_v<T> && std::is_base_of_v<message_header<typename T::protocol>, T>);
@@ -23,5 +27,24 @@ namespace bcpp::message
 } // namespace bcpp::message
 
 
+#include "./protocol/message_layout.h"
 #include "./receiver/receiver.h"
+#include "./receiver/partitioner.h"
+#include "./receiver/receiver_contract.h"
+#include "./receiver/receiver_thread_pool.h"
+#include "./receiver/subscription.h"
 #include "./transmitter/transmitter.h"
+#include "./transmitter/concurrent_transmitter.h"
+#include "./transmitter/lane_transmitter.h"
+#include "./transport/aligned_packet.h"
+#include "./transport/broadcaster.h"
+#include "./transport/gap_detector.h"
+#include "./transport/journal.h"
+#include "./transport/packet_batcher.h"
+#include "./transport/packet_pool.h"
+#include "./transport/packet_view.h"
+#include "./transport/sequencer.h"
+#include "./transport/shared_memory_ring.h"
+#include "./transport/shared_packet.h"
+#include "./transport/spsc_packet_queue.h"
+#include "./transport/mpsc_packet_queue.h"
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "./protocol.h"
+
+#include <include/constexpr_string.h>
+#include <include/endian.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a fixed sized field of a message_layout.  integral and enum fields are held in byte order E on the
+    // wire and converted by the accessors.  std::array<char, N> fields are string fields (read as a
+    // std::string_view and written from one, truncated and zero padded).
+    template <constexpr_string N, typename T, std::endian E = std::endian::native>
+    struct field
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "message fields must be trivially copyable");
+        static_assert((E == std::endian::native) || std::is_integral_v<T> || std::is_enum_v<T>, "only integral and enum fields have a byte order");
+
+        using value_type = T;
+        static auto constexpr name = N;
+        static auto constexpr endian = E;
+        static auto constexpr size = sizeof(T);
+        static auto constexpr tail = false;
+    };
+
+    template <constexpr_string N, typename T>
+    using big_endian_field = field<N, T, std::endian::big>;
+
+    template <constexpr_string N, typename T>
+    using little_endian_field = field<N, T, std::endian::little>;
+
+
+    //=========================================================================
+    // a variable length array of T which follows the fixed fields (and must therefore be the last field).
+    // its length is implied by the size of the message.
+    template <constexpr_string N, typename T, std::endian E = std::endian::native>
+    struct tail_field
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "message fields must be trivially copyable");
+        static_assert((E == std::endian::native) || std::is_integral_v<T> || std::is_enum_v<T>, "only integral and enum fields have a byte order");
+
+        using value_type = T;
+        static auto constexpr name = N;
+        static auto constexpr endian = E;
+        static auto constexpr size = std::size_t(0);
+        static auto constexpr tail = true;
+    };
+
+
+    //=========================================================================
+    // the representation of T in byte order E.  bcpp::big_endian and bcpp::little_endian (include/endian.h)
+    // convert on construction and on conversion back to T.
+    template <typename T, std::endian E>
+    using endian_type = std::conditional_t<(E == std::endian::native), T, std::conditional_t<(E == std::endian::big), big_endian<T>, little_endian<T>>>;
+
+
+    //=========================================================================
+    // write 'value' in byte order E to (possibly unaligned) 'destination'.  enums are written as their
+    // underlying type.
+    template <std::endian E, typename T>
+    void store_endian
+    (
+        std::byte * destination,
+        T value
+    )
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            store_endian<E>(destination, static_cast<std::underlying_type_t<T>>(value));
+        }
+        else
+        {
+            static_assert(sizeof(endian_type<T, E>) == sizeof(T));
+            endian_type<T, E> wireValue(value);
+            std::memcpy(destination, &wireValue, sizeof(wireValue));
+        }
+    }
+
+
+    //=========================================================================
+    // read a T in byte order E from (possibly unaligned) 'source'
+    template <typename T, std::endian E>
+    T load_endian
+    (
+        std::byte const * source
+    )
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            return static_cast<T>(load_endian<std::underlying_type_t<T>, E>(source));
+        }
+        else
+        {
+            std::array<std::byte, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), source, sizeof(T));
+            return static_cast<T>(std::bit_cast<endian_type<T, E>>(bytes));
+        }
+    }
+
+
+    //=========================================================================
+    // read only view of a message's tail array.  elements are copied out as they may be unaligned.
+    template <typename T, std::endian E>
+    class tail_view
+    {
+    public:
+
+        tail_view
+        (
+            std::byte const * data,
+            std::size_t size
+        ):
+            data_(data),
+            size_(size)
+        {
+        }
+
+        std::size_t size() const{return size_;}
+
+        bool empty() const{return (size_ == 0);}
+
+        T operator[]
+        (
+            std::size_t index
+        ) const
+        {
+            return load_endian<T, E>(data_ + (index * sizeof(T)));
+        }
+
+    private:
+
+        std::byte const *   data_;
+        std::size_t         size_;
+
+    }; // class tail_view
+
+
+    //=========================================================================
+    // generates the layout of a message from a list of fields (field, big_endian_field, little_endian_field
+    // and, last of all, an optional tail_field).  the fields are packed into a byte array directly after
+    // the header so the message is packed and trivially copyable without #pragma pack, provided that the
+    // header is itself packed (alignof 1, enforced) as otherwise the layout would inherit the header's 
+    // alignment and the padding would go out on the wire.  specialize message by deriving from the layout:
+    //
+    //      template <>
+    //      struct message<my_protocol, my_message_indicator::order> :
+    //          message_layout<my_protocol, my_message_indicator::order,
+    //                  big_endian_field<"price", std::int64_t>, field<"symbol", std::array<char, 8>>>
+    //      {
+    //          using message_layout::message_layout;
+    //      };
+    //
+    // the constructor takes a value for each of the leading fields (in order), the header's size is set
+    // automatically and the static size(args ...) means that transmitter::emplace() always constructs
+    // the message in place.  a message with a tail array must only be constructed in place (emplace() or
+    // reserve()) when given a tail as the tail is written beyond the end of the object.
+    // message_header<P> must be constructible from a message indicator and a size.
+    template <protocol_concept P, typename P::message_indicator M, typename ... Fs>
+    struct message_layout :
+        message_header<P>
+    {
+    private:
+
+        static_assert(alignof(message_header<P>) == 1, "message_layout requires a packed message_header (such as within #pragma pack(push, 1))");
+
+        static auto constexpr field_count = sizeof ... (Fs);
+
+        template <std::size_t I>
+        using field_at = std::tuple_element_t<I, std::tuple<Fs ...>>;
+
+        static constexpr bool has_tail()
+        {
+            if constexpr (field_count == 0)
+                return false;
+            else
+                return field_at<field_count - 1>::tail;
+        }
+
+        static auto constexpr fixed_field_count = (field_count - (has_tail() ? 1 : 0));
+        static auto constexpr payload_size = (std::size_t(0) + ... + Fs::size);
+
+        static_assert([]<std::size_t ... I>(std::index_sequence<I ...>){return (true && ... && (!field_at<I>::tail));}
+                (std::make_index_sequence<fixed_field_count>()), "only the last field may be a tail_field");
+
+        template <std::size_t I>
+        static constexpr std::size_t offset_of()
+        {
+            return []<std::size_t ... J>(std::index_sequence<J ...>){return (std::size_t(0) + ... + field_at<J>::size);}(std::make_index_sequence<I>());
+        }
+
+        template <constexpr_string N>
+        static constexpr std::size_t index_of()
+        {
+            std::size_t index = field_count;
+            [&]<std::size_t ... I>(std::index_sequence<I ...>)
+                    {
+                        ((((index == field_count) && (std::string_view(field_at<I>::name) == std::string_view(N))) ? (void)(index = I) : (void)0), ...);
+                    }(std::make_index_sequence<field_count>());
+            return index;
+        }
+
+        template <typename T>
+        static auto constexpr string_field = std::is_same_v<T, std::array<char, sizeof(T)>>;
+
+        template <std::size_t I, typename V>
+        static constexpr bool assignable()
+        {
+            using value_type = typename field_at<I>::value_type;
+            if constexpr (field_at<I>::tail)
+                return requires (V values){std::size(values); *std::begin(values);};
+            else if constexpr (string_field<value_type>)
+                return (std::is_convertible_v<V, std::string_view> || std::is_convertible_v<V, value_type>);
+            else
+                return std::is_convertible_v<V, value_type>;
+        }
+
+    public:
+
+        using protocol = P;
+        static auto constexpr type = M;
+
+        message_layout():
+            message_header<P>(M, sizeof(message_layout)),
+            payload_{}
+        {
+        }
+
+        template <typename ... Ts>
+        requires ((sizeof ... (Ts) > 0) && (sizeof ... (Ts) <= field_count) &&
+                []<std::size_t ... I>(std::index_sequence<I ...>){return (assignable<I, std::tuple_element_t<I, std::tuple<Ts ...>>>() && ...);}
+                (std::make_index_sequence<sizeof ... (Ts)>()))
+        message_layout
+        (
+            Ts && ... values
+        ):
+            message_header<P>(M, size(values ...)),
+            payload_{}
+        {
+            [&]<std::size_t ... I>(std::index_sequence<I ...>, auto && ... values)
+                    {
+                        (assign<I>(std::forward<decltype(values)>(values)), ...);
+                    }(std::make_index_sequence<sizeof ... (Ts)>(), std::forward<Ts>(values) ...);
+        }
+
+        // the size of a message constructed from these arguments.  fixed sized messages have a static
+        // size() and messages with a tail array have a static size(args ...).
+        static constexpr std::size_t size
+        (
+            auto const & ... values
+        ) requires ((!has_tail()) || (sizeof ... (values) > 0))
+        {
+            if constexpr (has_tail() && (sizeof ... (values) == field_count))
+            {
+                using element_type = typename field_at<field_count - 1>::value_type;
+                auto const & tail = std::get<field_count - 1>(std::forward_as_tuple(values ...));
+                return (sizeof(message_layout) + (std::size(tail) * sizeof(element_type)));
+            }
+            else
+            {
+                return sizeof(message_layout);
+            }
+        }
+
+        // the size of this message (including its tail)
+        std::size_t size() const requires (has_tail())
+        {
+            return message_header<P>::size();
+        }
+
+        // string fields are returned as a std::string_view (up to the first zero), a tail field as a
+        // tail_view and any other field by value (in native byte order)
+        template <constexpr_string N>
+        auto get() const
+        {
+            static auto constexpr index = index_of<N>();
+            static_assert(index < field_count, "no such field");
+            using field_type = field_at<index>;
+            using value_type = typename field_type::value_type;
+            if constexpr (field_type::tail)
+            {
+                auto bytes = (message_header<P>::size() - sizeof(message_layout));
+                return tail_view<value_type, field_type::endian>(reinterpret_cast<std::byte const *>(this) + sizeof(message_layout), bytes / sizeof(value_type));
+            }
+            else if constexpr (string_field<value_type>)
+            {
+                auto const * data = reinterpret_cast<char const *>(payload_.data() + offset_of<index>());
+                return std::string_view(data, std::find(data, data + sizeof(value_type), '\0'));
+            }
+            else
+            {
+                return load_endian<value_type, field_type::endian>(payload_.data() + offset_of<index>());
+            }
+        }
+
+        template <constexpr_string N, typename V>
+        void set
+        (
+            V && value
+        ) requires (!field_at<index_of<N>()>::tail)
+        {
+            static_assert(index_of<N>() < field_count, "no such field");
+            assign<index_of<N>()>(std::forward<V>(value));
+        }
+
+    private:
+
+        template <std::size_t I, typename V>
+        void assign
+        (
+            V && value
+        )
+        {
+            using field_type = field_at<I>;
+            using value_type = typename field_type::value_type;
+            if constexpr (field_type::tail)
+            {
+                // written directly beyond the fixed portion of the message (see above)
+                auto * destination = (reinterpret_cast<std::byte *>(this) + sizeof(message_layout));
+                for (auto const & element : value)
+                {
+                    store_endian<field_type::endian>(destination, static_cast<value_type>(element));
+                    destination += sizeof(value_type);
+                }
+            }
+            else if constexpr (string_field<value_type> && std::is_convertible_v<V, std::string_view>)
+            {
+                std::string_view source(value);
+                auto * destination = (payload_.data() + offset_of<I>());
+                std::memset(destination, 0, sizeof(value_type));
+                std::memcpy(destination, source.data(), std::min(source.size(), sizeof(value_type)));
+            }
+            else
+            {
+                store_endian<field_type::endian>(payload_.data() + offset_of<I>(), static_cast<value_type>(value));
+            }
+        }
+
+        [[no_unique_address]] std::array<std::byte, payload_size> payload_;
+
+    }; // struct message_layout
+
+} // namespace bcpp::message
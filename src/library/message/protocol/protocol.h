@@ -18,6 +18,14 @@ namespace bcpp::message
 
         static constexpr std::array<message_indicator, message_arity> messageIndicators_{T1 ...};
         static constexpr message_indicator get(std::size_t index){return messageIndicators_[index];}
+        // position of the message indicator within the protocol (message_arity if not part of the protocol)
+        static constexpr std::size_t index_of(message_indicator messageIndicator)
+        {
+            for (std::size_t i = 0; i < message_arity; ++i)
+                if (messageIndicators_[i] == messageIndicator)
+                    return i;
+            return message_arity;
+        }
     };
 
 
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <library/message/protocol/protocol.h>
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    // the unsigned integral type underlying a message indicator (which may be either an enum or integral)
+    template <typename T>
+    using underlying_message_indicator_t = std::make_unsigned_t<typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>, std::type_identity<T>>::type>;
+
+
+    enum class dispatch_strategy : std::uint8_t
+    {
+        inline_switch,      // small sets: a fold over the indicators which the compiler lowers to a switch and inlines the handlers
+        dense_table,        // contiguous sets: a jump table indexed by (indicator - lowest indicator)
+        perfect_hash,       // sparse or wide sets: a constexpr perfect hash into a power of two table
+        binary_search       // fallback when no perfect hash could be found
+    };
+
+
+    //=========================================================================
+    // compile time dispatch engine generated from protocol::messageIndicators_
+    // H must provide:
+    //      template <message_indicator> static constexpr bool handles();
+    //      template <message_indicator> static void dispatch_message(H &, void const *);
+    template <typename H, protocol_concept P>
+    class dispatcher
+    {
+    public:
+
+        using protocol = P;
+        using message_indicator = typename protocol::message_indicator;
+        using key_type = std::uint64_t;
+        using handler = void(*)(H &, void const *);
+
+        static auto constexpr inline_dispatch_limit = 16;
+        static auto constexpr dense_table_limit = (1 << 12);
+        static auto constexpr dense_table_max_sparsity = 4;
+        static auto constexpr perfect_hash_max_attempts = 256;
+
+        static constexpr key_type to_key
+        (
+            message_indicator messageIndicator
+        ) noexcept
+        {
+            return static_cast<underlying_message_indicator_t<message_indicator>>(messageIndicator);
+        }
+
+        // returns false if the message indicator is not handled
+        static bool dispatch
+        (
+            message_indicator,
+            H &,
+            void const *
+        );
+
+    private:
+
+        struct entry
+        {
+            key_type    key_{std::numeric_limits<key_type>::max()};
+            handler     handler_{nullptr};
+        };
+
+        struct hash_parameters
+        {
+            bool        found_{false};
+            key_type    multiplier_{0};
+            std::size_t bits_{0};
+        };
+
+        template <message_indicator M>
+        static void invoke
+        (
+            H & h,
+            void const * address
+        )
+        {
+            H::template dispatch_message<M>(h, address);
+        }
+
+        template <std::size_t N>
+        static constexpr bool handles() noexcept
+        {
+            return H::template handles<protocol::get(N)>();
+        }
+
+        static auto constexpr handled_count = []<std::size_t ... N>(std::index_sequence<N ...>)
+                {
+                    return (std::size_t(0) + ... + std::size_t(handles<N>()));
+                }(std::make_index_sequence<protocol::message_arity>());
+
+        static auto constexpr handled_ = []<std::size_t ... N>(std::index_sequence<N ...>)
+                {
+                    std::array<entry, handled_count> handled;
+                    std::size_t index = 0;
+                    ([&]()
+                        {
+                            if constexpr (handles<N>())
+                                handled[index++] = {to_key(protocol::get(N)), invoke<protocol::get(N)>};
+                        }(), ...);
+                    // sort by key for the sake of binary search
+                    for (std::size_t i = 1; i < handled.size(); ++i)
+                        for (std::size_t j = i; ((j > 0) && (handled[j].key_ < handled[j - 1].key_)); --j)
+                            std::swap(handled[j], handled[j - 1]);
+                    return handled;
+                }(std::make_index_sequence<protocol::message_arity>());
+
+        static auto constexpr lowest_key = (handled_count == 0) ? key_type(0) : handled_.front().key_;
+        static auto constexpr key_range = (handled_count == 0) ? key_type(0) : (handled_.back().key_ - lowest_key + 1);
+
+        static constexpr key_type hash
+        (
+            key_type key,
+            key_type multiplier,
+            std::size_t bits
+        ) noexcept
+        {
+            return ((bits == 0) ? 0 : ((key * multiplier) >> ((sizeof(key_type) * 8) - bits)));
+        }
+
+        static consteval hash_parameters find_perfect_hash()
+        {
+            // multiplicative hash search.  try successively larger tables (up to 8x the number of
+            // handled indicators) and a deterministic sequence of odd multipliers until every handled
+            // key maps to a unique slot.
+            auto minimumBits = std::size_t(std::bit_width(std::bit_ceil(handled_count)) - 1);
+            for (auto bits = minimumBits; bits <= minimumBits + 3; ++bits)
+            {
+                key_type state = 0x9e3779b97f4a7c15ull;
+                for (auto attempt = 0; attempt < perfect_hash_max_attempts; ++attempt)
+                {
+                    // splitmix64
+                    state += 0x9e3779b97f4a7c15ull;
+                    auto multiplier = state;
+                    multiplier = (multiplier ^ (multiplier >> 30)) * 0xbf58476d1ce4e5b9ull;
+                    multiplier = (multiplier ^ (multiplier >> 27)) * 0x94d049bb133111ebull;
+                    multiplier = ((multiplier ^ (multiplier >> 31)) | 1);
+
+                    std::array<bool, (std::bit_ceil(handled_count) << 3)> used{};
+                    bool collision = false;
+                    for (std::size_t i = 0; ((!collision) && (i < handled_count)); ++i)
+                    {
+                        auto slot = hash(handled_[i].key_, multiplier, bits);
+                        collision = used[slot];
+                        used[slot] = true;
+                    }
+                    if (!collision)
+                        return {true, multiplier, bits};
+                }
+            }
+            return {};
+        }
+
+        static auto constexpr select_strategy() noexcept
+        {
+            if constexpr (handled_count <= inline_dispatch_limit)
+                return dispatch_strategy::inline_switch;
+            else if constexpr ((key_range <= dense_table_limit) && (key_range <= (handled_count * dense_table_max_sparsity)))
+                return dispatch_strategy::dense_table;
+            else if constexpr (find_perfect_hash().found_)
+                return dispatch_strategy::perfect_hash;
+            else
+                return dispatch_strategy::binary_search;
+        }
+
+    public:
+
+        static auto constexpr strategy = select_strategy();
+
+    private:
+
+        static auto constexpr hash_parameters_ = (strategy == dispatch_strategy::perfect_hash) ? find_perfect_hash() : hash_parameters{};
+
+        static auto constexpr table_ = []()
+                {
+                    if constexpr (strategy == dispatch_strategy::dense_table)
+                    {
+                        std::array<handler, key_range> table{};
+                        for (auto const & [key, handler] : handled_)
+                            table[key - lowest_key] = handler;
+                        return table;
+                    }
+                    else if constexpr (strategy == dispatch_strategy::perfect_hash)
+                    {
+                        std::array<entry, (std::size_t(1) << hash_parameters_.bits_)> table{};
+                        for (auto const & e : handled_)
+                            table[hash(e.key_, hash_parameters_.multiplier_, hash_parameters_.bits_)] = e;
+                        return table;
+                    }
+                    else
+                    {
+                        return handled_;
+                    }
+                }();
+
+        template <std::size_t ... N>
+        static bool dispatch_inline
+        (
+            std::index_sequence<N ...>,
+            message_indicator messageIndicator,
+            H & h,
+            void const * address
+        )
+        {
+            // a chain of compares against constants.  the handlers are called directly (and are
+            // therefore candidates for inlining) and the compiler is free to lower the chain to a switch.
+            return ([&]()
+                {
+                    if constexpr (handles<N>())
+                    {
+                        if (messageIndicator == protocol::get(N))
+                        {
+                            H::template dispatch_message<protocol::get(N)>(h, address);
+                            return true;
+                        }
+                    }
+                    return false;
+                }() || ...);
+        }
+
+    }; // class dispatcher
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <typename H, bcpp::message::protocol_concept P>
+inline bool bcpp::message::dispatcher<H, P>::dispatch
+(
+    message_indicator messageIndicator,
+    H & h,
+    void const * address
+)
+{
+    if constexpr (strategy == dispatch_strategy::inline_switch)
+    {
+        return dispatch_inline(std::make_index_sequence<protocol::message_arity>(), messageIndicator, h, address);
+    }
+    else if constexpr (strategy == dispatch_strategy::dense_table)
+    {
+        auto index = (to_key(messageIndicator) - lowest_key); // wraps for keys below the lowest key
+        if (index >= table_.size())
+            return false;
+        if (auto handler = table_[index]; handler != nullptr)
+        {
+            handler(h, address);
+            return true;
+        }
+        return false;
+    }
+    else if constexpr (strategy == dispatch_strategy::perfect_hash)
+    {
+        auto key = to_key(messageIndicator);
+        if (auto const & e = table_[hash(key, hash_parameters_.multiplier_, hash_parameters_.bits_)]; ((e.key_ == key) && (e.handler_ != nullptr)))
+        {
+            e.handler_(h, address);
+            return true;
+        }
+        return false;
+    }
+    else
+    {
+        auto key = to_key(messageIndicator);
+        std::size_t low = 0;
+        std::size_t high = table_.size();
+        while (low < high)
+        {
+            auto mid = ((low + high) / 2);
+            if (table_[mid].key_ < key)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if ((low < table_.size()) && (table_[low].key_ == key))
+        {
+            table_[low].handler_(h, address);
+            return true;
+        }
+        return false;
+    }
+}
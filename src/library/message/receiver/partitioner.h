@@ -0,0 +1,305 @@
+#pragma once
+
+#include "./receiver.h"
+#include <library/message/transmitter/transmitter.h>
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a key extractor provides an overload of operator() for each message type which is to be partitioned
+    // by key (such as the instrument id or account of the message).  the key is either integral or hashable.
+    template <typename K, typename M>
+    concept key_extractor_for = requires (K const keyExtractor, M const & message)
+            {
+                {keyExtractor(message)};
+                requires (std::is_integral_v<std::decay_t<decltype(keyExtractor(message))>> ||
+                        requires (std::decay_t<decltype(keyExtractor(message))> key){std::hash<std::decay_t<decltype(key)>>()(key);});
+            };
+
+
+    //=========================================================================
+    // key partitioned fan out.  messages pushed into the partitioner are hashed by key to one of N workers
+    // and their raw bytes are forwarded, unchanged, through a per worker transmitter.  all messages with the
+    // same key go to the same worker and therefore retain their relative order.  messages without a key
+    // (no overload in K) go to a single configurable worker.
+    //
+    // forwarding is batched.  each worker's packet is handed to the worker packet handler (typically
+    // 'workers[index] << std::move(packet)' where each worker is a receiver with a concurrent packet queue
+    // such as spsc_packet_queue) only when it is full or trips the flush policy, and once at the end of each
+    // process_all() or process_n().  after process_next_message() call flush() to hand off partial packets.
+    template <protocol_concept P, typename K, packet_queue_concept Q = std::queue<std::vector<char>>, packet_concept T = std::vector<char>>
+    class partitioner final :
+        public receiver<partitioner<P, K, Q, T>, P, Q>
+    {
+    public:
+
+        using key_extractor = K;
+        using worker_packet = T;
+        using base_type = receiver<partitioner<P, K, Q, T>, P, Q>;
+
+        struct worker_packet_binding;
+
+        using worker_transmitter = transmitter<P, worker_packet, type_erased_handler, worker_packet_binding>;
+
+        // receives each forwarded packet along with the index of the worker it is destined for
+        using worker_packet_handler = std::function<void(std::size_t, worker_packet &&)>;
+
+        struct configuration
+        {
+            std::size_t                                         workerCount_{1};
+            std::size_t                                         unkeyedWorker_{0};  // destination of messages without a key
+            typename worker_transmitter::configuration          workerTransmitterConfiguration_{};
+            typename base_type::configuration                   receiverConfiguration_{};
+        };
+
+        struct event_handlers
+        {
+            worker_packet_handler                               workerPacketHandler_;
+            typename worker_transmitter::packet_allocate_handler workerPacketAllocateHandler_;
+            typename base_type::event_handlers                  receiverEventHandlers_;
+        };
+
+        // hands each of a worker transmitter's packets to the partitioner's worker packet handler
+        struct worker_packet_binding
+        {
+            void operator()
+            (
+                worker_transmitter const &,
+                worker_packet packet
+            ) const
+            {
+                partitioner_->workerPacketHandler_(worker_, std::move(packet));
+            }
+
+            partitioner *   partitioner_;
+            std::size_t     worker_;
+        };
+
+        template <typename ... Ts>
+        partitioner
+        (
+            configuration const &,
+            event_handlers,
+            Ts && ...
+        );
+
+        // worker transmitters refer back to the partitioner
+        partitioner(partitioner &&) = delete;
+        partitioner & operator = (partitioner &&) = delete;
+
+        ~partitioner();
+
+        std::size_t process_all();
+
+        std::size_t process_n
+        (
+            std::size_t maxMessages,
+            std::size_t maxBytes = std::numeric_limits<std::size_t>::max()
+        );
+
+        // hand every worker's partially filled packet to the worker packet handler
+        void flush();
+
+        std::size_t get_worker_count() const;
+
+        // the index of the worker which receives messages of type M with the given key
+        template <typename M>
+        std::size_t get_worker_index
+        (
+            M const &
+        ) const;
+
+        // messages forwarded to the given worker so far
+        std::size_t get_messages_forwarded
+        (
+            std::size_t
+        ) const;
+
+    private:
+
+        friend base_type;
+
+        template <message_concept M>
+        void operator()
+        (
+            M const &
+        );
+
+        std::size_t to_worker_index
+        (
+            std::uint64_t
+        ) const;
+
+        [[no_unique_address]] key_extractor                 keyExtractor_;
+
+        worker_packet_handler                               workerPacketHandler_;
+
+        std::size_t                                         unkeyedWorker_;
+
+        std::vector<std::unique_ptr<worker_transmitter>>    workerTransmitters_;
+
+        std::vector<std::size_t>                            messagesForwarded_;
+
+    }; // class partitioner
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+template <typename ... Ts>
+bcpp::message::partitioner<P, K, Q, T>::partitioner
+(
+    configuration const & config,
+    event_handlers eventHandlers,
+    Ts && ... packetQueueArgs
+):
+    base_type(config.receiverConfiguration_, std::move(eventHandlers.receiverEventHandlers_), std::forward<Ts>(packetQueueArgs) ...),
+    workerPacketHandler_(std::move(eventHandlers.workerPacketHandler_)),
+    unkeyedWorker_(0),
+    messagesForwarded_(std::max<std::size_t>(config.workerCount_, 1), 0)
+{
+    if (!workerPacketHandler_)
+        workerPacketHandler_ = [](auto, auto &&){};
+    unkeyedWorker_ = std::min(config.unkeyedWorker_, messagesForwarded_.size() - 1);
+    workerTransmitters_.reserve(messagesForwarded_.size());
+    for (std::size_t i = 0; i < messagesForwarded_.size(); ++i)
+        workerTransmitters_.push_back(std::make_unique<worker_transmitter>(config.workerTransmitterConfiguration_,
+                typename worker_transmitter::event_handlers{eventHandlers.workerPacketAllocateHandler_, {this, i}}));
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+bcpp::message::partitioner<P, K, Q, T>::~partitioner
+(
+)
+{
+    flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+template <bcpp::message::message_concept M>
+inline void bcpp::message::partitioner<P, K, Q, T>::operator()
+(
+    M const & message
+)
+{
+    auto workerIndex = get_worker_index(message);
+    workerTransmitters_[workerIndex]->send(message);
+    ++messagesForwarded_[workerIndex];
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+template <typename M>
+inline std::size_t bcpp::message::partitioner<P, K, Q, T>::get_worker_index
+(
+    M const & message
+) const
+{
+    if constexpr (key_extractor_for<key_extractor, M>)
+    {
+        using key_type = std::decay_t<decltype(keyExtractor_(message))>;
+        if constexpr (std::is_integral_v<key_type>)
+            return to_worker_index(static_cast<std::uint64_t>(keyExtractor_(message)));
+        else
+            return to_worker_index(static_cast<std::uint64_t>(std::hash<key_type>()(keyExtractor_(message))));
+    }
+    else
+    {
+        return unkeyedWorker_;
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+inline std::size_t bcpp::message::partitioner<P, K, Q, T>::to_worker_index
+(
+    std::uint64_t key
+) const
+{
+    // keys such as sequential ids are poorly distributed in their low bits so mix every bit of the key
+    // (splitmix64 finalizer) then map onto [0, workerCount) with a multiply rather than a divide
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    key ^= (key >> 31);
+    return static_cast<std::size_t>((static_cast<unsigned __int128>(key) * workerTransmitters_.size()) >> 64);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+std::size_t bcpp::message::partitioner<P, K, Q, T>::process_all
+(
+)
+{
+    auto messagesDispatched = base_type::process_all();
+    flush();
+    return messagesDispatched;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+std::size_t bcpp::message::partitioner<P, K, Q, T>::process_n
+(
+    std::size_t maxMessages,
+    std::size_t maxBytes
+)
+{
+    auto messagesDispatched = base_type::process_n(maxMessages, maxBytes);
+    flush();
+    return messagesDispatched;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+void bcpp::message::partitioner<P, K, Q, T>::flush
+(
+)
+{
+    for (auto & workerTransmitter : workerTransmitters_)
+        workerTransmitter->flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+std::size_t bcpp::message::partitioner<P, K, Q, T>::get_worker_count
+(
+) const
+{
+    return workerTransmitters_.size();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, typename K, bcpp::message::packet_queue_concept Q, bcpp::message::packet_concept T>
+std::size_t bcpp::message::partitioner<P, K, Q, T>::get_messages_forwarded
+(
+    std::size_t workerIndex
+) const
+{
+    return messagesForwarded_[workerIndex];
+}
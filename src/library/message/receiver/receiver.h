@@ -1,22 +1,37 @@
 #pragma once
 
+#include "./dispatcher.h"
+#include "./subscription.h"
+#include <library/message/instrumentation/instrumentation.h>
+#include <library/message/instrumentation/trace.h>
 #include <library/message/transport/packet_queue.h>
 
 #include <include/non_copyable.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <span>
 #include <type_traits>
 #include <cstdint>
+#include <chrono>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <queue>
+#include <thread>
+#include <unordered_set>
 #include <concepts>
+#include <cstring>
+#include <utility>
 
 
 namespace bcpp::message
 {
 
-    template <typename T, protocol_concept P, packet_queue_concept Q = std::queue<std::vector<char const>>>
+    template <typename T, protocol_concept P, packet_queue_concept Q = std::queue<std::vector<char const>>, typename H = type_erased_handler>
     class receiver :
         virtual non_copyable
     {
@@ -26,19 +41,60 @@ namespace bcpp::message
         using protocol = P;
         using packet_queue = Q;
         using packet = typename packet_queue::value_type;
+        using packet_discard_handler_type = H;
         using protocol_traits = typename protocol::traits;
         using message_indicator = protocol_traits::message_indicator;
-        using underlying_message_indicator = std::make_unsigned_t<std::underlying_type_t<message_indicator>>;
+        using underlying_message_indicator = underlying_message_indicator_t<message_indicator>;
+        using subscription_type = subscription<protocol>;
+
+        // packet queues which declare themselves 'concurrent' (such as spsc_packet_queue) allow packets to be 
+        // pushed (operator <<) from a different thread than the one which processes the messages.
+        static auto constexpr concurrent_packet_queue = requires {requires packet_queue::concurrent;};
 
         struct configuration 
         {
+            // every packet begins with a packet_trace (the transmitter must be configured likewise)
+            bool tracePackets_{false};
+            // bytes at the very start of every packet which belong to an outer framing layer (such as the
+            // sequencer's sequence_header) and are skipped (the transmitter must be configured likewise)
+            std::size_t packetHeadroom_{0};
+            // latest value conflation.  when process_all() or process_n() finds more than this many bytes
+            // available, only the newest message per key is delivered (zero disables).  see conflation_key().
+            std::size_t conflationThreshold_{0};
+            // message types to deliver.  messages of any other type (or of a type which 'target' does not
+            // handle) are skipped without being dispatched.  see subscribe().
+            subscription_type subscriptions_ = subscription_type::all();
         };
 
-        using packet_discard_handler = std::function<void(receiver const &, packet &&)>;
+        // the discard handler is either type erased (std::function) or a statically bound callable (H)
+        static auto constexpr type_erased_packet_discard_handler = std::is_same_v<H, type_erased_handler>;
+
+        using packet_discard_handler = std::conditional_t<type_erased_packet_discard_handler, std::function<void(receiver const &, packet &&)>, H>;
+
+        // optional.  observes every packet pushed into the receiver (such as journal_writer capturing the 
+        // packet stream).  called by the thread which pushes the packet.
+        using packet_capture_handler = std::function<void(receiver const &, packet const &)>;
 
         struct event_handlers
         {
             packet_discard_handler  packetDiscardHandler_;
+            packet_capture_handler  packetCaptureHandler_;
+        };
+
+        struct message_statistics
+        {
+            message_indicator       messageIndicator_{};
+            std::size_t             messages_{0};
+            std::size_t             bytes_{0};
+            histogram               handlerTime_;           // sampled handler execution time (nanoseconds)
+        };
+
+        // snapshot of the hot path statistics.  only collected when instrumentation_enabled.
+        struct statistics
+        {
+            std::array<message_statistics, protocol::message_arity> messages_{};
+            std::size_t             directMessages_{0};     // dispatched directly from the packet
+            std::size_t             straddledMessages_{0};  // reassembled in the straddle buffer before dispatch
         };
 
         template <typename ... Ts>
@@ -63,10 +119,80 @@ namespace bcpp::message
 
         bool process_next_message();
 
+        // drain every complete message currently available.  returns the number of messages dispatched.
+        std::size_t process_all();
+
+        // drain until either the message count or the byte budget is exhausted (whichever comes first).
+        // returns the number of messages dispatched.
+        std::size_t process_n
+        (
+            std::size_t maxMessages,
+            std::size_t maxBytes = std::numeric_limits<std::size_t>::max()
+        );
+
+        // drain until the deadline passes.  the clock is sampled once at least deadline_check_interval
+        // messages have been dispatched since it was last sampled so the deadline may be overshot by at most
+        // that many messages (or by the remainder of a batch handler's run).
+        template <typename C, typename D>
+        std::size_t process_for
+        (
+            std::chrono::time_point<C, D> deadline,
+            std::size_t maxMessages = std::numeric_limits<std::size_t>::max()
+        );
+
+        template <typename R, typename D>
+        std::size_t process_for
+        (
+            std::chrono::duration<R, D> duration,
+            std::size_t maxMessages = std::numeric_limits<std::size_t>::max()
+        );
+
         std::size_t get_bytes_available() const;
 
         bool empty() const;
 
+        // call from the thread which processes messages.  returns an empty snapshot if instrumentation is disabled.
+        statistics get_statistics() const;
+
+        // call from the thread which processes messages.  returns empty histograms if tracing is disabled.
+        trace_statistics get_trace_statistics() const;
+
+        // messages which were superseded (and therefore not delivered) while conflating.  conflation requires
+        // configuration::conflationThreshold_ and a target which provides, for each conflatable message type,
+        //      std::uint64_t conflation_key(message_type const &) const;
+        // (such as the instrument id of a quote).
+        std::size_t get_messages_conflated() const;
+
+        // runtime subscription.  call from the thread which processes messages.  the message types which are
+        // delivered are those subscribed to here which 'target' also handles (and, if 'target' declares
+        //      static constexpr subscription<protocol> subscriptions;
+        // which are also part of that compile time set).
+        void subscribe
+        (
+            message_indicator
+        );
+
+        void unsubscribe
+        (
+            message_indicator
+        );
+
+        void set_subscriptions
+        (
+            subscription_type const &
+        );
+
+        subscription_type get_subscriptions() const;
+
+        // true if messages of this type are delivered
+        bool is_subscribed
+        (
+            message_indicator
+        ) const;
+
+        // messages skipped because they were not subscribed to (these are not counted as dispatched)
+        std::size_t get_messages_filtered() const;
+
         void close();
 
         receiver & operator << 
@@ -83,14 +209,174 @@ namespace bcpp::message
         {
             using message_header = bcpp::message::message_header<P>;
             message_header const & messageHeader = *reinterpret_cast<message_header const *>(source.data());
-            if (auto callback = callback_[static_cast<underlying_message_indicator>(messageHeader.get_message_indicator())]; callback != nullptr)
-                callback(*this, source.data());
+            if ((filtering_) && (!is_subscribed(messageHeader.get_message_indicator())))
+            {
+                ++messagesFiltered_;
+                return;
+            }
+            deliver(source);
         }
 
     private:
 
-        static auto constexpr bits_per_byte = 8;
-        static auto constexpr max_underlying_message_indicator_value = (1 << (sizeof(underlying_message_indicator) * bits_per_byte));
+        void deliver
+        (
+            std::span<std::uint8_t const> source
+        )
+        {
+            using message_header = bcpp::message::message_header<P>;
+            message_header const & messageHeader = *reinterpret_cast<message_header const *>(source.data());
+            dispatcher_type::dispatch(messageHeader.get_message_indicator(), *this, source.data());
+        }
+
+        template <typename, protocol_concept> friend class dispatcher;
+
+        using dispatcher_type = dispatcher<receiver, protocol>;
+
+        static auto constexpr deadline_check_interval = 16;
+
+        // the subscription lookup is a table indexed by (indicator - lowest indicator) when the protocol's
+        // indicators span no more than this many values and otherwise a table indexed by a hash of the
+        // indicator (open addressing at no more than a quarter full)
+        static auto constexpr subscription_table_limit = (1 << 12);
+
+        static constexpr std::uint64_t to_key
+        (
+            message_indicator messageIndicator
+        )
+        {
+            return static_cast<underlying_message_indicator>(messageIndicator);
+        }
+
+        static auto constexpr key_bounds_ = []()
+                {
+                    std::pair<std::uint64_t, std::uint64_t> bounds{std::numeric_limits<std::uint64_t>::max(), 0};
+                    for (auto messageIndicator : protocol::messageIndicators_)
+                        bounds = {std::min<std::uint64_t>(bounds.first, static_cast<underlying_message_indicator>(messageIndicator)),
+                                std::max<std::uint64_t>(bounds.second, static_cast<underlying_message_indicator>(messageIndicator))};
+                    return bounds;
+                }();
+
+        static auto constexpr lowest_key = (protocol::message_arity == 0) ? std::uint64_t(0) : key_bounds_.first;
+        static auto constexpr dense_subscription_table = ((protocol::message_arity == 0) || ((key_bounds_.second - lowest_key) < subscription_table_limit));
+        static auto constexpr subscription_table_size = dense_subscription_table ? 
+                static_cast<std::size_t>(key_bounds_.second - lowest_key + 1) : std::bit_ceil(protocol::message_arity * 4);
+
+        // only used by the hashed table (a dense table can have a single slot which would shift by 64)
+        static auto constexpr subscription_hash = [](std::uint64_t key) -> std::size_t
+                {
+                    if constexpr (dense_subscription_table)
+                        return 0;
+                    else
+                        return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15ull) >> (64 - std::bit_width(subscription_table_size - 1))) & (subscription_table_size - 1);
+                };
+
+        // for the hashed table: the key and protocol index held by each slot (message_arity when empty)
+        static auto constexpr hashed_keys_ = []()
+                {
+                    std::array<std::pair<std::uint64_t, std::size_t>, (dense_subscription_table ? 0 : subscription_table_size)> slots;
+                    slots.fill({0, protocol::message_arity});
+                    if constexpr (!dense_subscription_table)
+                        for (std::size_t i = 0; i < protocol::message_arity; ++i)
+                        {
+                            std::uint64_t key = static_cast<underlying_message_indicator>(protocol::get(i));
+                            auto slot = subscription_hash(key);
+                            while (slots[slot].second != protocol::message_arity)
+                                slot = ((slot + 1) & (subscription_table_size - 1));
+                            slots[slot] = {key, i};
+                        }
+                    return slots;
+                }();
+
+        // the compile time subscription declared by 'target' (every message type if none is declared)
+        template <message_indicator M>
+        static constexpr bool statically_subscribed()
+        {
+            if constexpr (requires {{target::subscriptions} -> std::convertible_to<subscription_type>;})
+                return subscription_type(target::subscriptions).contains(M);
+            else
+                return true;
+        }
+
+        // a function rather than a constant as 'target' is incomplete when the receiver is instantiated
+        static constexpr subscription_type handled_subscriptions()
+        {
+            subscription_type handled;
+            []<std::size_t ... N>(subscription_type & handled, std::index_sequence<N ...>)
+                    {
+                        ((handles<protocol::get(N)>() ? (void)handled.insert(protocol::get(N)) : (void)0), ...);
+                    }(handled, std::make_index_sequence<protocol::message_arity>());
+            return handled;
+        }
+
+        template <message_indicator M>
+        static constexpr bool handles_message()
+        {
+            return requires (target t, message<protocol, M> m){t(m);};
+        }
+
+        // 'target' may instead (or as well) accept a contiguous run of messages of a fixed sized type via
+        //      void operator()(std::span<message_type const>);
+        // consecutive messages of that type within a packet are then delivered in a single call (see drain()).
+        template <message_indicator M>
+        static constexpr bool handles_batch()
+        {
+            return requires (target t, std::span<message<protocol, M> const> messages){t(messages);};
+        }
+
+        template <message_indicator M>
+        static constexpr bool handles()
+        {
+            // only dispatch a message type if 'target' supports receiving that message type
+            // TODO: add some kind of warning that this type of receiver has no handler for this type of message
+            return ((handles_message<M>() || handles_batch<M>()) && statically_subscribed<M>());
+        }
+
+        // a function rather than a constant as 'target' is incomplete when the receiver is instantiated
+        static constexpr bool batching_supported()
+        {
+            return []<std::size_t ... N>(std::index_sequence<N ...>)
+                    {
+                        return (handles_batch<protocol::get(N)>() || ...);
+                    }(std::make_index_sequence<protocol::message_arity>());
+        }
+
+        // a message type is conflatable if 'target' provides an integral conflation_key() for it.  messages
+        // of other types are never conflated.
+        template <message_indicator M>
+        static constexpr bool conflates()
+        {
+            return requires (target const t, message<protocol, M> const m){{t.conflation_key(m)} -> std::convertible_to<std::uint64_t>;};
+        }
+
+        // a function rather than a constant as 'target' is incomplete when the receiver is instantiated
+        static constexpr bool conflation_supported()
+        {
+            return []<std::size_t ... N>(std::index_sequence<N ...>)
+                    {
+                        return (conflates<protocol::get(N)>() || ...);
+                    }(std::make_index_sequence<protocol::message_arity>());
+        }
+
+        struct conflation_entry
+        {
+            std::size_t     offset_;
+            std::size_t     size_;
+            std::size_t     messageIndex_;
+            std::uint64_t   key_;
+            bool            conflatable_;
+            bool            superseded_;
+        };
+
+        // messages collected from the backlog by conflate()
+        struct conflation_state
+        {
+            bool                                                        collecting_{false};
+            std::vector<char>                                           messages_;
+            std::vector<conflation_entry>                               entries_;
+            std::array<std::unordered_set<std::uint64_t>, protocol::message_arity> keys_;
+            std::size_t                                                 messagesConflated_{0};
+        };
 
         template <message_indicator M>
         static void dispatch_message
@@ -100,72 +386,244 @@ namespace bcpp::message
         )
         {
             using message_type = message<protocol, M>;
-            reinterpret_cast<target &>(self)(*reinterpret_cast<message_type const *>(address));
+            auto const & incomingMessage = *reinterpret_cast<message_type const *>(address);
+            if constexpr (conflation_supported())
+            {
+                if ((self.conflation_) && (self.conflation_->collecting_))
+                {
+                    std::uint64_t key = 0;
+                    if constexpr (conflates<M>())
+                        key = static_cast<std::uint64_t>(reinterpret_cast<target const &>(self).conflation_key(incomingMessage));
+                    self.collect(address, protocol::index_of(M), key, conflates<M>());
+                    return;
+                }
+            }
+            if constexpr (instrumentation_enabled)
+            {
+                auto & messageStatistics = self.statistics_.messages_[protocol::index_of(M)];
+                messageStatistics.bytes_ += reinterpret_cast<message_header<protocol> const *>(address)->size();
+                if ((messageStatistics.messages_++ % handler_sample_interval) == 0)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    invoke_handler(self, incomingMessage);
+                    messageStatistics.handlerTime_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                    return;
+                }
+            }
+            invoke_handler(self, incomingMessage);
+        }
+
+        template <message_concept M>
+        static void invoke_handler
+        (
+            receiver & self,
+            M const & incomingMessage
+        )
+        {
+            // a target with only a batch handler receives single messages as a run of one
+            if constexpr (handles_message<M::type>())
+                reinterpret_cast<target &>(self)(incomingMessage);
+            else
+                reinterpret_cast<target &>(self)(std::span<M const>(&incomingMessage, 1));
+        }
+
+        // deliver the run of consecutive messages of type M (each exactly sizeof(M) bytes) which begins at
+        // 'begin' in a single call to the target's batch handler.  returns the number of messages delivered.
+        template <message_indicator M>
+        static std::size_t dispatch_batch
+        (
+            receiver & self,
+            std::uint8_t const * begin,
+            std::uint8_t const * end,
+            std::size_t maxMessages
+        )
+        {
+            using message_type = message<protocol, M>;
+            std::size_t count = 0;
+            for (auto current = begin; ((count < maxMessages) && (static_cast<std::size_t>(end - current) >= sizeof(message_type))); current += sizeof(message_type), ++count)
+            {
+                auto const & messageHeader = *reinterpret_cast<message_header<protocol> const *>(current);
+                if ((messageHeader.get_message_indicator() != M) || (messageHeader.size() != sizeof(message_type)))
+                    break; // end of run
+            }
+            if (count == 0)
+                return 0;
+            if constexpr (instrumentation_enabled)
+            {
+                auto & messageStatistics = self.statistics_.messages_[protocol::index_of(M)];
+                messageStatistics.messages_ += count;
+                messageStatistics.bytes_ += (count * sizeof(message_type));
+            }
+            reinterpret_cast<target &>(self)(std::span(reinterpret_cast<message_type const *>(begin), count));
+            return count;
+        }
+
+        // returns zero if the target has no batch handler for the message type
+        template <std::size_t ... N>
+        std::size_t dispatch_run
+        (
+            std::index_sequence<N ...>,
+            message_indicator messageIndicator,
+            std::uint8_t const * begin,
+            std::uint8_t const * end,
+            std::size_t maxMessages
+        )
+        {
+            std::size_t count = 0;
+            ([&]()
+                {
+                    if constexpr (handles_batch<protocol::get(N)>())
+                    {
+                        if (messageIndicator == protocol::get(N))
+                        {
+                            count = dispatch_batch<protocol::get(N)>(*this, begin, end, maxMessages);
+                            return true;
+                        }
+                    }
+                    return false;
+                }() || ...);
+            return count;
         }
 
         void clear();
 
-        bool buffer_next_packet();
+        std::size_t get_bytes_pushed() const;
+
+        // rebuild the lookup of the message types which are delivered
+        void update_subscriptions();
+
+        // drain the backlog (within the budget) into the conflation buffer then deliver, in order, every
+        // message which is not superseded by a newer message of the same type and key
+        std::size_t conflate
+        (
+            std::size_t,
+            std::size_t
+        );
+
+        void collect
+        (
+            void const *,
+            std::size_t,
+            std::uint64_t,
+            bool
+        );
+
+        void discard_next_packet();
+
+        void discard
+        (
+            packet &&
+        );
+
+        bool straddle
+        (
+            std::size_t
+        );
+
+        void trace_next_packet();
+
+        std::size_t dispatch_next_message();
+
+        template <typename F>
+        std::size_t drain
+        (
+            std::size_t,
+            std::size_t,
+            F
+        );
 
         packet_queue            packets_;
 
-        std::vector<char>       buffered_;
+        std::vector<char>       straddled_;
+
+        [[no_unique_address]] packet_discard_handler  packetDiscardHandler_;
+
+        packet_capture_handler  packetCaptureHandler_;
 
-        packet_discard_handler  packetDiscardHandler_;
+        // bytes pushed are counted by the producer (operator <<) and bytes consumed by the consumer so that 
+        // neither side writes to the other's counter.
+        using byte_counter = std::conditional_t<concurrent_packet_queue, std::atomic<std::size_t>, std::size_t>;
 
-        std::size_t             bytesAvailable_{0};
+        byte_counter            bytesPushed_{0};
+
+        std::size_t             bytesConsumed_{0};
 
         std::size_t             bytesConsumedInNextPacket_{0};
 
-        static std::array<void(*)(receiver &, void const *), max_underlying_message_indicator_value> callback_;
+        std::size_t             packetHeadroom_{0};
 
-    }; // class receiver
+        bool                    tracePackets_{false};
+
+        // size of the headroom plus the trace prefix (if tracing) of every packet
+        std::size_t             packetPrefixSize_{0};
+
+        bool                    nextPacketTraced_{false};
+
+        std::uint64_t           straddleStartTime_{0};
 
+        std::unique_ptr<trace_statistics> traceStatistics_;
 
-    template <typename T, protocol_concept P, packet_queue_concept Q>
-    std::array<void(*)(receiver<T, P, Q> &, void const *), receiver<T, P, Q>::max_underlying_message_indicator_value> receiver<T, P, Q>::callback_;
+        std::size_t             conflationThreshold_{0};
+
+        std::unique_ptr<conflation_state> conflation_;     // only when conflation is configured
+
+        subscription_type       subscriptions_;
+
+        // subscribed and handled.  only when some message type of the protocol is not delivered.
+        bool                    filtering_{false};
+
+        subscription_type       deliveredSubscriptions_;
+
+        std::vector<std::uint8_t> subscriptionTable_;       // see subscription_table_limit
+
+        std::size_t             messagesFiltered_{0};
+
+        [[no_unique_address]] std::conditional_t<instrumentation_enabled, statistics, no_statistics> statistics_;
+
+    }; // class receiver
 
 
     template <typename T>
-    concept receiver_concept = std::is_same_v<T, receiver<typename T::target, typename T::protocol, typename T::packet_queue>>;
+    concept receiver_concept = std::is_same_v<T, receiver<typename T::target, typename T::protocol, typename T::packet_queue, typename T::packet_discard_handler_type>>;
 
 } // namespace bcpp::message
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
 template <typename ... Ts>
-bcpp::message::receiver<T, P, Q>::receiver 
+bcpp::message::receiver<T, P, Q, H>::receiver 
 (
     configuration const & config,
     event_handlers eventHandlers,
     Ts && ... packetQueueArgs
 ):
     packets_(std::forward<Ts>(packetQueueArgs) ...),
-    packetDiscardHandler_(eventHandlers.packetDiscardHandler_)
+    packetDiscardHandler_(eventHandlers.packetDiscardHandler_),
+    packetCaptureHandler_(std::move(eventHandlers.packetCaptureHandler_))
 {    
-    static auto once = [&]<std::size_t ... N>(std::index_sequence<N ...>)
+    packetHeadroom_ = config.packetHeadroom_;
+    tracePackets_ = config.tracePackets_;
+    packetPrefixSize_ = (packetHeadroom_ + (tracePackets_ ? sizeof(packet_trace) : 0));
+    bytesConsumedInNextPacket_ = packetPrefixSize_;
+    if (tracePackets_)
+        traceStatistics_ = std::make_unique<trace_statistics>();
+    if (config.conflationThreshold_ != 0)
     {
-        for (auto & callback : callback_)
-            callback = nullptr;
-        ([&]()
-            {    
-                // only configure a callback if 'target' supports receiving that message type
-                if constexpr (requires (target t, message<protocol, P::get(N)> m){t(m);})
-                    callback_[static_cast<underlying_message_indicator>(P::get(N))] = dispatch_message<P::get(N)>;
-                else
-                {
-                    // TODO: add some kind of warning that this type of receiver has no handler for this type of message
-                }
-            }(), ...);
-        return true;
-    }(std::make_index_sequence<protocol::messageIndicators_.size()>());
+        conflationThreshold_ = config.conflationThreshold_;
+        conflation_ = std::make_unique<conflation_state>();
+    }
+    subscriptions_ = config.subscriptions_;
+    update_subscriptions();
+    if constexpr (instrumentation_enabled)
+        for (std::size_t i = 0; i < protocol::message_arity; ++i)
+            statistics_.messages_[i].messageIndicator_ = protocol::get(i);
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-bcpp::message::receiver<T, P, Q>::~receiver
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bcpp::message::receiver<T, P, Q, H>::~receiver
 (
 )
 {
@@ -174,26 +632,44 @@ bcpp::message::receiver<T, P, Q>::~receiver
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-bcpp::message::receiver<T, P, Q>::receiver
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bcpp::message::receiver<T, P, Q, H>::receiver
 (
     receiver && other
 ):
     packets_(std::move(other.packets_)),
-    buffered_(std::move(other.buffered_)),
+    straddled_(std::move(other.straddled_)),
     packetDiscardHandler_(std::move(other.packetDiscardHandler_)),
-    bytesAvailable_(other.bytesAvailable_),
-    bytesConsumedInNextPacket_(other.bytesConsumedInNextPacket_)
+    packetCaptureHandler_(std::move(other.packetCaptureHandler_)),
+    bytesPushed_(other.get_bytes_pushed()),
+    bytesConsumed_(other.bytesConsumed_),
+    bytesConsumedInNextPacket_(other.bytesConsumedInNextPacket_),
+    packetHeadroom_(other.packetHeadroom_),
+    tracePackets_(other.tracePackets_),
+    packetPrefixSize_(other.packetPrefixSize_),
+    nextPacketTraced_(other.nextPacketTraced_),
+    straddleStartTime_(other.straddleStartTime_),
+    traceStatistics_(std::move(other.traceStatistics_)),
+    conflationThreshold_(other.conflationThreshold_),
+    conflation_(std::move(other.conflation_)),
+    subscriptions_(other.subscriptions_),
+    filtering_(other.filtering_),
+    deliveredSubscriptions_(other.deliveredSubscriptions_),
+    subscriptionTable_(other.subscriptionTable_),
+    messagesFiltered_(other.messagesFiltered_),
+    statistics_(other.statistics_)
 {
-    other.packetDiscardHandler_ = nullptr;
-    other.bytesAvailable_ = 0;
-    other.bytesConsumedInNextPacket_ = 0;
+    if constexpr (type_erased_packet_discard_handler)
+        other.packetDiscardHandler_ = nullptr;
+    other.bytesPushed_ = 0;
+    other.bytesConsumed_ = 0;
+    other.bytesConsumedInNextPacket_ = other.packetPrefixSize_;
 }
 
         
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-auto bcpp::message::receiver<T, P, Q>::operator =
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+auto bcpp::message::receiver<T, P, Q, H>::operator =
 (
     receiver && other
 ) -> receiver & 
@@ -202,156 +678,656 @@ auto bcpp::message::receiver<T, P, Q>::operator =
     {
         clear();
         packets_ = std::move(other.packets_);
-        buffered_ = std::move(other.buffered_);
+        straddled_ = std::move(other.straddled_);
         packetDiscardHandler_ = std::move(other.packetDiscardHandler_);
-        bytesAvailable_ = other.bytesAvailable_;
+        packetCaptureHandler_ = std::move(other.packetCaptureHandler_);
+        bytesPushed_ = other.get_bytes_pushed();
+        bytesConsumed_ = other.bytesConsumed_;
         bytesConsumedInNextPacket_ = other.bytesConsumedInNextPacket_;
-        other.packetDiscardHandler_ = nullptr;
-        other.bytesAvailable_ = 0;
-        other.bytesConsumedInNextPacket_ = 0;
+        packetHeadroom_ = other.packetHeadroom_;
+        tracePackets_ = other.tracePackets_;
+        packetPrefixSize_ = other.packetPrefixSize_;
+        nextPacketTraced_ = other.nextPacketTraced_;
+        straddleStartTime_ = other.straddleStartTime_;
+        traceStatistics_ = std::move(other.traceStatistics_);
+        conflationThreshold_ = other.conflationThreshold_;
+        conflation_ = std::move(other.conflation_);
+        subscriptions_ = other.subscriptions_;
+        filtering_ = other.filtering_;
+        deliveredSubscriptions_ = other.deliveredSubscriptions_;
+        subscriptionTable_ = other.subscriptionTable_;
+        messagesFiltered_ = other.messagesFiltered_;
+        statistics_ = other.statistics_;
+        if constexpr (type_erased_packet_discard_handler)
+            other.packetDiscardHandler_ = nullptr;
+        other.bytesPushed_ = 0;
+        other.bytesConsumed_ = 0;
+        other.bytesConsumedInNextPacket_ = other.packetPrefixSize_;
     }
     return *this;
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-void bcpp::message::receiver<T, P, Q>::clear
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::clear
 (
 )
 {
     while (!packets_.empty())
     {
         auto && p = packets_.front();
-        bytesAvailable_ -= p.size();
-        if (packetDiscardHandler_)
-            packetDiscardHandler_(*this, std::forward<packet>(p));
+        discard(std::forward<packet>(p));
         packets_.pop();
     }
 
-    buffered_.clear();
-    bytesAvailable_ = 0;
-    bytesConsumedInNextPacket_ = 0;
+    straddled_.clear();
+    bytesConsumed_ = get_bytes_pushed();
+    bytesConsumedInNextPacket_ = packetPrefixSize_;
+    nextPacketTraced_ = false;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::get_bytes_pushed
+(
+) const
+{
+    if constexpr (concurrent_packet_queue)
+        return bytesPushed_.load(std::memory_order_acquire);
+    else
+        return bytesPushed_;
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-auto bcpp::message::receiver<T, P, Q>::operator << 
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+auto bcpp::message::receiver<T, P, Q, H>::operator << 
 (
     packet && p
 ) -> receiver &
 {
-    bytesAvailable_ += p.size();
-    packets_.push(std::move(p));
+    if (packetCaptureHandler_)
+        packetCaptureHandler_(*this, p);
+    // the prefix is not part of the message stream.  a packet shorter than its prefix contributes nothing
+    // and is discarded (unread) once it reaches the front of the queue.
+    auto size = ((p.size() > packetPrefixSize_) ? (p.size() - packetPrefixSize_) : 0);
+    if constexpr (requires (packet_queue queue, packet p){{queue.push(std::move(p))} -> std::same_as<bool>;})
+    {
+        // bounded queue.  apply back pressure until there is room for the packet.
+        while (!packets_.push(std::move(p)))
+            std::this_thread::yield();
+    }
+    else
+    {
+        packets_.push(std::move(p));
+    }
+
+    // count the bytes only once the packet has been pushed so that they are never visible to the consumer before the packet is
+    if constexpr (concurrent_packet_queue)
+        bytesPushed_.fetch_add(size, std::memory_order_release);
+    else
+        bytesPushed_ += size;
     return *this;
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-bool bcpp::message::receiver<T, P, Q>::buffer_next_packet
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::discard_next_packet
 (
 )
 {
-    if (packets_.empty())
-        return false;
     auto && p = packets_.front();
-    std::copy_n(p.begin() + bytesConsumedInNextPacket_, p.size() - bytesConsumedInNextPacket_, std::back_inserter(buffered_));
-    if (packetDiscardHandler_)
-        packetDiscardHandler_(*this, std::forward<packet>(p));
+    discard(std::forward<packet>(p));
     packets_.pop();
-    bytesConsumedInNextPacket_ = 0;
+    bytesConsumedInNextPacket_ = packetPrefixSize_;
+    nextPacketTraced_ = false;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::discard
+(
+    packet && p
+)
+{
+    if constexpr (type_erased_packet_discard_handler)
+    {
+        if (packetDiscardHandler_)
+            packetDiscardHandler_(*this, std::move(p));
+    }
+    else
+    {
+        packetDiscardHandler_(*this, std::move(p));
+    }
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bool bcpp::message::receiver<T, P, Q, H>::straddle
+(
+    std::size_t size
+)
+{
+    // copy bytes from the next packet(s) into the straddle buffer until it holds 'size' bytes.
+    // only the bytes of the message which straddles the packet boundary are ever copied.
+    while (straddled_.size() < size)
+    {
+        if (packets_.empty())
+            return false;
+        if (packets_.front().size() <= bytesConsumedInNextPacket_)
+        {
+            discard_next_packet(); // no message bytes (shorter than its prefix)
+            continue;
+        }
+        if ((tracePackets_) && (!nextPacketTraced_))
+            trace_next_packet();
+        auto & nextPacket = packets_.front();
+        auto bytesToCopy = std::min(nextPacket.size() - bytesConsumedInNextPacket_, size - straddled_.size());
+        straddled_.insert(straddled_.end(), nextPacket.data() + bytesConsumedInNextPacket_, nextPacket.data() + bytesConsumedInNextPacket_ + bytesToCopy);
+        bytesConsumedInNextPacket_ += bytesToCopy;
+        if (bytesConsumedInNextPacket_ == nextPacket.size())
+            discard_next_packet();
+    }
     return true;
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-bool bcpp::message::receiver<T, P, Q>::process_next_message
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::trace_next_packet
+(
+)
+{
+    // record the stage latencies of the next packet the first time it is read
+    packet_trace trace;
+    std::memcpy(&trace, packets_.front().data() + packetHeadroom_, sizeof(trace));
+    auto now = trace_time();
+    traceStatistics_->parked_.record(trace.flushedTime_ - trace.bufferedTime_);
+    traceStatistics_->transit_.record(now - trace.flushedTime_);
+    traceStatistics_->endToEnd_.record(now - trace.bufferedTime_);
+    nextPacketTraced_ = true;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bool bcpp::message::receiver<T, P, Q, H>::process_next_message
+(
+)
+{
+    // step over any messages which are not subscribed to
+    for (auto messagesFiltered = messagesFiltered_; dispatch_next_message() != 0; messagesFiltered = messagesFiltered_)
+        if (messagesFiltered_ == messagesFiltered)
+            return true;
+    return false;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::dispatch_next_message
 (
 )
 {
+    // dispatches a single message and returns its size (or zero if no complete message was available)
     using message_header = message_header<protocol>;
     static auto constexpr minimum_data_to_parse_header = sizeof(message_header);
 
-    if (bytesAvailable_ < minimum_data_to_parse_header)
-        return false; // insufficient data to continue
+    auto bytesAvailable = get_bytes_available();
+    if (bytesAvailable < minimum_data_to_parse_header)
+        return 0; // insufficient data to continue
 
-    while (buffered_.empty())
+    if (straddled_.empty())
     {
         // attempt to parse directly from the next packet
+        // (with multiple producers the byte count can run ahead of the packets which are visible so check for empty)
+        while ((!packets_.empty()) && (packets_.front().size() <= bytesConsumedInNextPacket_))
+            discard_next_packet(); // next packet is entirely consumed
+        if (packets_.empty())
+            return 0;
+        if ((tracePackets_) && (!nextPacketTraced_))
+            trace_next_packet();
         auto & nextPacket = packets_.front();
         auto bytesAvailableInNextPacket = nextPacket.size() - bytesConsumedInNextPacket_;
-        if (bytesAvailableInNextPacket < minimum_data_to_parse_header)
+        if (bytesAvailableInNextPacket >= minimum_data_to_parse_header)
         {
-            // the next packet isn't large enough to represent the header so buffer it
-            buffer_next_packet();
-            continue;
+            // there is sufficient data in the next packet to represent a header
+            auto const & messageHeader = *reinterpret_cast<message_header const *>(nextPacket.data() + bytesConsumedInNextPacket_);
+            std::size_t messageSize = messageHeader.size();
+            if (bytesAvailableInNextPacket >= messageSize)
+            {
+                // the next packet has sufficient data to represent an entire message
+                if (bytesAvailable < messageSize)
+                    return 0; // its bytes have not been counted yet
+                bytesConsumedInNextPacket_ += messageSize;
+                bytesConsumed_ += messageSize;
+                if constexpr (instrumentation_enabled)
+                    ++statistics_.directMessages_;
+                process(std::span(reinterpret_cast<std::uint8_t const *>(&messageHeader), messageSize)); // dispatch the message
+                if (bytesConsumedInNextPacket_ == nextPacket.size())
+                    discard_next_packet();
+                return messageSize; // message dispatched
+            }
         }
+        // the next message straddles the packet boundary
+    }
+
+    // reassemble the straddling message in the straddle buffer.  once dispatched, parsing resumes
+    // directly from the packet which contained the end of this message.
+    if ((tracePackets_) && (straddled_.empty()))
+        straddleStartTime_ = trace_time();
+    if (!straddle(minimum_data_to_parse_header))
+        return 0; // insufficient data to represent a header at this time
+    std::size_t messageSize = reinterpret_cast<message_header const *>(straddled_.data())->size();
+    if ((bytesAvailable < messageSize) || (!straddle(messageSize)))
+        return 0; // insufficient data to represent the message at this time
+
+    bytesConsumed_ += messageSize;
+    if constexpr (instrumentation_enabled)
+        ++statistics_.straddledMessages_;
+    if (tracePackets_)
+        traceStatistics_->reassembly_.record(trace_time() - straddleStartTime_);
+    process(std::span(reinterpret_cast<std::uint8_t const *>(straddled_.data()), messageSize)); // dispatch the message
+    straddled_.clear();
+    return messageSize; // message dispatched
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+template <typename F>
+std::size_t bcpp::message::receiver<T, P, Q, H>::drain
+(
+    std::size_t maxMessages,
+    std::size_t maxBytes,
+    F hasExpired
+)
+{
+    // walk every complete message within the next packet in a single tight loop and only fall back to
+    // the straddle logic (dispatch_next_message) at packet boundaries.  runs of messages for which the
+    // target has a batch handler are delivered in a single call.  messages which are not subscribed to
+    // are stepped over using only their headers and count toward neither budget.
+    using message_header = message_header<protocol>;
+    static auto constexpr minimum_data_to_parse_header = sizeof(message_header);
 
-        // there is sufficient data in the next packet to represent a header
-        auto const & messageHeader = *reinterpret_cast<message_header const *>(nextPacket.data() + bytesConsumedInNextPacket_);
-        auto messageSize = messageHeader.size();
-        if (bytesAvailableInNextPacket < messageSize)
+    std::size_t messagesDispatched = 0;
+    std::size_t bytesDispatched = 0;
+    auto exhausted = [&](){return ((messagesDispatched >= maxMessages) || (bytesDispatched >= maxBytes) || hasExpired(messagesDispatched));};
+
+    while (!exhausted())
+    {
+        if ((straddled_.empty()) && (!packets_.empty()))
         {
-            // the next packet isn't large enough to represent the entire message so buffer it
-            buffer_next_packet();
-            continue;
+            if (packets_.front().size() <= bytesConsumedInNextPacket_)
+            {
+                discard_next_packet(); // no message bytes (shorter than its prefix)
+                continue;
+            }
+            if ((tracePackets_) && (!nextPacketTraced_))
+                trace_next_packet();
+            // snapshot the bytes pushed before reading the packet and consume no more than that.  with a
+            // concurrent queue the packet can be visible before its bytes have been counted.
+            auto bytesAvailable = get_bytes_available();
+            auto & nextPacket = packets_.front();
+            auto const * begin = reinterpret_cast<std::uint8_t const *>(nextPacket.data()) + bytesConsumedInNextPacket_;
+            auto const * end = begin + std::min(nextPacket.size() - bytesConsumedInNextPacket_, bytesAvailable);
+            auto const * current = begin;
+            auto messagesDispatchedBefore = messagesDispatched;
+            bool done = false;
+            while (static_cast<std::size_t>(end - current) >= minimum_data_to_parse_header)
+            {
+                auto const & messageHeader = *reinterpret_cast<message_header const *>(current);
+                std::size_t messageSize = messageHeader.size();
+                if (static_cast<std::size_t>(end - current) < messageSize)
+                    break; // message straddles the packet boundary
+                if ((filtering_) && (!is_subscribed(messageHeader.get_message_indicator())))
+                {
+                    // skip it.  its bytes are accounted for in bulk along with the rest of the packet.
+                    current += messageSize;
+                    ++messagesFiltered_;
+                    continue;
+                }
+                if constexpr (batching_supported())
+                {
+                    if ((!conflation_) || (!conflation_->collecting_))
+                    {
+                        // deliver a run of messages to a batch handler (within the remaining budget)
+                        auto remainingBytes = (maxBytes - bytesDispatched);
+                        auto maxRun = std::min(maxMessages - messagesDispatched, (remainingBytes / messageSize) + ((remainingBytes % messageSize) != 0));
+                        if (auto count = dispatch_run(std::make_index_sequence<protocol::message_arity>(), messageHeader.get_message_indicator(), current, end, maxRun); count > 0)
+                        {
+                            current += (count * messageSize);
+                            messagesDispatched += count;
+                            bytesDispatched += (count * messageSize);
+                            if ((done = exhausted()))
+                                break;
+                            continue;
+                        }
+                    }
+                }
+                deliver(std::span(current, messageSize)); // dispatch the message
+                current += messageSize;
+                ++messagesDispatched;
+                bytesDispatched += messageSize;
+                if ((done = exhausted()))
+                    break;
+            }
+            // account for everything consumed from this packet in bulk
+            bytesConsumedInNextPacket_ += (current - begin);
+            bytesConsumed_ += (current - begin);
+            if constexpr (instrumentation_enabled)
+                statistics_.directMessages_ += (messagesDispatched - messagesDispatchedBefore);
+            if (done)
+            {
+                if (bytesConsumedInNextPacket_ == nextPacket.size())
+                    discard_next_packet();
+                break;
+            }
+            if (bytesConsumedInNextPacket_ == nextPacket.size())
+            {
+                // consumed to its end so resume directly from the next packet (with its runs intact)
+                discard_next_packet();
+                continue;
+            }
         }
 
-        // the next packet has sufficient data to represent an entire message
-        bytesConsumedInNextPacket_ += messageSize;
-        bytesAvailable_ -= messageSize;
-        process(std::span(reinterpret_cast<std::uint8_t const *>(&messageHeader), messageSize)); // dispatch the message
-        return true; // message dispatched
+        // a message straddles the packet boundary.  use the straddle logic to dispatch it.
+        auto messagesFiltered = messagesFiltered_;
+        auto messageSize = dispatch_next_message();
+        if (messageSize == 0)
+            break; // insufficient data to represent a message at this time
+        if (messagesFiltered_ != messagesFiltered)
+            continue; // skipped rather than dispatched
+        ++messagesDispatched;
+        bytesDispatched += messageSize;
     }
+    return messagesDispatched;
+}
 
-    while (true)
-    {
-        // parse using the buffered data
-        if (buffered_.size() < minimum_data_to_parse_header)
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::process_all
+(
+)
+{
+    if constexpr (conflation_supported())
+        if ((conflationThreshold_ != 0) && (get_bytes_available() > conflationThreshold_))
+            return conflate(std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max());
+    return drain(std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max(), [](std::size_t){return false;});
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::process_n
+(
+    std::size_t maxMessages,
+    std::size_t maxBytes
+)
+{
+    if constexpr (conflation_supported())
+        if ((conflationThreshold_ != 0) && (get_bytes_available() > conflationThreshold_))
+            return conflate(maxMessages, maxBytes);
+    return drain(maxMessages, maxBytes, [](std::size_t){return false;});
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+template <typename C, typename D>
+std::size_t bcpp::message::receiver<T, P, Q, H>::process_for
+(
+    std::chrono::time_point<C, D> deadline,
+    std::size_t maxMessages
+)
+{
+    // a batch handler's run advances the count by more than one so sample the clock once at least
+    // deadline_check_interval messages have been dispatched since it was last sampled (rather than on
+    // multiples of the interval which a run can step over)
+    return drain(maxMessages, std::numeric_limits<std::size_t>::max(), [deadline, nextCheck = std::size_t(0)](std::size_t messagesDispatched) mutable
+            {
+                if (messagesDispatched < nextCheck)
+                    return false;
+                nextCheck = (messagesDispatched + deadline_check_interval);
+                return (C::now() >= deadline);
+            });
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+template <typename R, typename D>
+std::size_t bcpp::message::receiver<T, P, Q, H>::process_for
+(
+    std::chrono::duration<R, D> duration,
+    std::size_t maxMessages
+)
+{
+    return process_for(std::chrono::steady_clock::now() + duration, maxMessages);
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::get_bytes_available
+(
+) const
+{
+    return (get_bytes_pushed() - bytesConsumed_);
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bool bcpp::message::receiver<T, P, Q, H>::empty
+(
+) const
+{
+    return (get_bytes_available() == 0);
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+auto bcpp::message::receiver<T, P, Q, H>::get_statistics
+(
+) const -> statistics
+{
+    if constexpr (instrumentation_enabled)
+        return statistics_;
+    else
+        return {};
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+auto bcpp::message::receiver<T, P, Q, H>::get_trace_statistics
+(
+) const -> trace_statistics
+{
+    if (traceStatistics_)
+        return *traceStatistics_;
+    return {};
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::collect
+(
+    void const * address,
+    std::size_t messageIndex,
+    std::uint64_t key,
+    bool conflatable
+)
+{
+    auto & messages = conflation_->messages_;
+    auto size = reinterpret_cast<message_header<protocol> const *>(address)->size();
+    auto offset = messages.size();
+    messages.insert(messages.end(), reinterpret_cast<char const *>(address), reinterpret_cast<char const *>(address) + size);
+    conflation_->entries_.push_back({offset, size, messageIndex, key, conflatable, false});
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::conflate
+(
+    std::size_t maxMessages,
+    std::size_t maxBytes
+)
+{
+    // pass one: collect the backlog (dispatch_message() copies each message into the conflation buffer)
+    auto & conflation = *conflation_;
+    conflation.collecting_ = true;
+    drain(maxMessages, maxBytes, [](std::size_t){return false;});
+    conflation.collecting_ = false;
+
+    // pass two: newest first, mark every conflatable message whose key has already been seen as superseded
+    auto & entries = conflation.entries_;
+    for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry)
+        if ((entry->conflatable_) && (!conflation.keys_[entry->messageIndex_].insert(entry->key_).second))
         {
-            // buffered data contains insufficient data to represent the message header so buffer next packet
-            if (!buffer_next_packet())
-                return false; // insufficient data to represent a message at this time
-            continue;
+            entry->superseded_ = true;
+            ++conflation.messagesConflated_;
         }
-        // there is sufficient data in the next packet to represent a header
-        auto const & messageHeader = *reinterpret_cast<message_header const *>(buffered_.data());
-        auto messageSize = messageHeader.size();
-        if (buffered_.size() < messageSize)
+
+    // deliver the survivors in their original order
+    std::size_t messagesDispatched = 0;
+    for (auto const & entry : entries)
+        if (!entry.superseded_)
         {
-            // the next packet isn't large enough to represent the entire message so buffer more
-            if (!buffer_next_packet())
-                return false; // insufficient data to represent a header at this time
-            continue;
+            process(std::span(reinterpret_cast<std::uint8_t const *>(conflation.messages_.data() + entry.offset_), entry.size_));
+            ++messagesDispatched;
         }
 
-        // the next packet has sufficient data to represent an entire message
-        bytesAvailable_ -= messageSize;
-        process(std::span(reinterpret_cast<std::uint8_t const *>(buffered_.data()), messageSize)); // dispatch the message
-        buffered_.erase(buffered_.begin(), buffered_.begin() + messageSize);
-        return true; // message dispatched
+    conflation.messages_.clear();
+    conflation.entries_.clear();
+    for (auto & keys : conflation.keys_)
+        keys.clear();
+    return messagesDispatched;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::get_messages_conflated
+(
+) const
+{
+    if (conflation_)
+        return conflation_->messagesConflated_;
+    return 0;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::update_subscriptions
+(
+)
+{
+    deliveredSubscriptions_ = (subscriptions_ & handled_subscriptions());
+    filtering_ = (deliveredSubscriptions_ != subscription_type::all());
+    subscriptionTable_.assign(subscription_table_size, 0);
+    if constexpr (dense_subscription_table)
+    {
+        for (std::size_t i = 0; i < protocol::message_arity; ++i)
+            subscriptionTable_[to_key(protocol::get(i)) - lowest_key] = deliveredSubscriptions_.contains_index(i);
+    }
+    else
+    {
+        for (std::size_t slot = 0; slot < hashed_keys_.size(); ++slot)
+            subscriptionTable_[slot] = deliveredSubscriptions_.contains_index(hashed_keys_[slot].second);
     }
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-std::size_t bcpp::message::receiver<T, P, Q>::get_bytes_available
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::subscribe
+(
+    message_indicator messageIndicator
+)
+{
+    subscriptions_.insert(messageIndicator);
+    update_subscriptions();
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::unsubscribe
+(
+    message_indicator messageIndicator
+)
+{
+    subscriptions_.erase(messageIndicator);
+    update_subscriptions();
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+void bcpp::message::receiver<T, P, Q, H>::set_subscriptions
+(
+    subscription_type const & subscriptions
+)
+{
+    subscriptions_ = subscriptions;
+    update_subscriptions();
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+auto bcpp::message::receiver<T, P, Q, H>::get_subscriptions
+(
+) const -> subscription_type
+{
+    return subscriptions_;
+}
+
+
+//=============================================================================
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+bool bcpp::message::receiver<T, P, Q, H>::is_subscribed
 (
+    message_indicator messageIndicator
 ) const
 {
-    return bytesAvailable_;
+    if constexpr (dense_subscription_table)
+    {
+        // indicators below the lowest wrap around to beyond the end of the table
+        auto index = (to_key(messageIndicator) - lowest_key);
+        return ((index < subscriptionTable_.size()) && (subscriptionTable_[index] != 0));
+    }
+    else
+    {
+        auto key = to_key(messageIndicator);
+        for (auto slot = subscription_hash(key); ; slot = ((slot + 1) & (subscription_table_size - 1)))
+        {
+            if (hashed_keys_[slot].second == protocol::message_arity)
+                return false; // not part of the protocol
+            if (hashed_keys_[slot].first == key)
+                return (subscriptionTable_[slot] != 0);
+        }
+    }
 }
 
 
 //=============================================================================
-template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q>
-bool bcpp::message::receiver<T, P, Q>::empty
+template <typename T, bcpp::message::protocol_concept P, bcpp::message::packet_queue_concept Q, typename H>
+std::size_t bcpp::message::receiver<T, P, Q, H>::get_messages_filtered
 (
 ) const
 {
-    return (bytesAvailable_ == 0);
+    return messagesFiltered_;
 }
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <include/non_copyable.h>
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // binds a receiver to a work contract so that a fixed pool of threads (servicing the work contract 
+    // group G) can service any number of receivers without idle polling.  pushing a packet schedules the 
+    // contract and the contract drains at most a fairness budget of messages before yielding the thread, 
+    // rescheduling itself if messages remain.
+    //
+    // G is any work contract group whose create_contract(callable) returns a contract which provides 
+    // schedule() (and optionally release()).  a contract is never executed by more than one thread at a time
+    // and scheduling a contract while it executes causes it to execute again afterwards.  the receiver must
+    // have a concurrent packet queue since packets are pushed by threads other than the one processing them.
+    template <typename R, typename G>
+    class receiver_contract :
+        non_copyable
+    {
+    public:
+
+        using receiver_type = R;
+        using work_contract_group = G;
+        using packet = typename receiver_type::packet;
+
+        static_assert(receiver_type::concurrent_packet_queue, "receiver_contract requires a concurrent packet queue (such as mpsc_packet_queue)");
+
+        static auto constexpr default_max_messages_per_execution = 256;
+
+        struct configuration
+        {
+            // fairness budget.  the contract yields the thread once either limit is reached.
+            std::size_t maxMessagesPerExecution_{default_max_messages_per_execution};
+            std::size_t maxBytesPerExecution_{std::numeric_limits<std::size_t>::max()};
+        };
+
+        receiver_contract
+        (
+            configuration const &,
+            receiver_type &,
+            work_contract_group &
+        );
+
+        ~receiver_contract();
+
+        // push the packet into the receiver and schedule the contract
+        receiver_contract & operator <<
+        (
+            packet &&
+        );
+
+        void schedule();
+
+        // messages dispatched by the contract so far
+        std::size_t get_messages_processed() const;
+
+    private:
+
+        void execute();
+
+        using work_contract = decltype(std::declval<work_contract_group &>().create_contract(std::declval<void(*)()>()));
+
+        std::size_t             maxMessagesPerExecution_;
+
+        std::size_t             maxBytesPerExecution_;
+
+        receiver_type &         receiver_;
+
+        std::atomic<std::size_t> messagesProcessed_{0};
+
+        work_contract           workContract_;
+
+    }; // class receiver_contract
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <typename R, typename G>
+bcpp::message::receiver_contract<R, G>::receiver_contract
+(
+    configuration const & config,
+    receiver_type & receiver,
+    work_contract_group & workContractGroup
+):
+    maxMessagesPerExecution_((config.maxMessagesPerExecution_ == 0) ? default_max_messages_per_execution : config.maxMessagesPerExecution_),
+    maxBytesPerExecution_((config.maxBytesPerExecution_ == 0) ? std::numeric_limits<std::size_t>::max() : config.maxBytesPerExecution_),
+    receiver_(receiver),
+    workContract_(workContractGroup.create_contract([this](){execute();}))
+{
+    if (!receiver_.empty())
+        schedule();
+}
+
+
+//=============================================================================
+template <typename R, typename G>
+bcpp::message::receiver_contract<R, G>::~receiver_contract
+(
+)
+{
+    if constexpr (requires (work_contract workContract){workContract.release();})
+        workContract_.release();
+}
+
+
+//=============================================================================
+template <typename R, typename G>
+auto bcpp::message::receiver_contract<R, G>::operator <<
+(
+    packet && p
+) -> receiver_contract &
+{
+    receiver_ << std::move(p);
+    schedule();
+    return *this;
+}
+
+
+//=============================================================================
+template <typename R, typename G>
+void bcpp::message::receiver_contract<R, G>::schedule
+(
+)
+{
+    workContract_.schedule();
+}
+
+
+//=============================================================================
+template <typename R, typename G>
+void bcpp::message::receiver_contract<R, G>::execute
+(
+)
+{
+    auto messagesProcessed = receiver_.process_n(maxMessagesPerExecution_, maxBytesPerExecution_);
+    messagesProcessed_.fetch_add(messagesProcessed, std::memory_order_relaxed);
+    // if the budget was exhausted with data remaining then go to the back of the line rather than starve other
+    // contracts.  the remaining data might only be the start of a message which is still arriving in which
+    // case the next execution dispatches nothing and does not reschedule.  the push which completes the 
+    // message schedules the contract again.
+    if ((messagesProcessed > 0) && (!receiver_.empty()))
+        schedule();
+}
+
+
+//=============================================================================
+template <typename R, typename G>
+std::size_t bcpp::message::receiver_contract<R, G>::get_messages_processed
+(
+) const
+{
+    return messagesProcessed_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <include/non_copyable.h>
+#include <library/system.h>
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a fixed pool of threads which service a work contract group (and therefore every receiver_contract
+    // created from that group).  threads block in the group while there is no work if the group supports
+    // a timed wait (execute_next_contract(duration)) and otherwise yield between attempts.  threads can 
+    // optionally be pinned to cpus (via the system library).  a thread which can not be pinned still runs
+    // (unpinned) but the failure is counted and reported to the pin failure handler.
+    template <typename G>
+    class receiver_thread_pool :
+        non_copyable
+    {
+    public:
+
+        using work_contract_group = G;
+
+        struct configuration
+        {
+            std::size_t         threadCount_{1};
+            std::vector<int>    cpus_;  // thread i is pinned to cpus_[i % cpus_.size()].  empty for no pinning.
+        };
+
+        // called by a thread which failed to pin itself with its thread index and cpu
+        using pin_failure_handler = std::function<void(std::size_t, int)>;
+
+        struct event_handlers
+        {
+            pin_failure_handler pinFailureHandler_;
+        };
+
+        receiver_thread_pool
+        (
+            configuration const &,
+            work_contract_group &,
+            event_handlers = {}
+        );
+
+        // stops and joins the threads
+        ~receiver_thread_pool();
+
+        void stop();
+
+        // threads which failed to pin themselves to their cpu
+        std::size_t get_pin_failure_count() const;
+
+    private:
+
+        static auto constexpr wait_timeout = std::chrono::milliseconds(10);
+
+        static bool pin_this_thread
+        (
+            int
+        );
+
+        void run
+        (
+            std::size_t
+        );
+
+        configuration               config_;
+
+        work_contract_group &       workContractGroup_;
+
+        pin_failure_handler         pinFailureHandler_;
+
+        std::atomic<std::size_t>    pinFailureCount_{0};
+
+        std::atomic<bool>           stopped_{false};
+
+        std::vector<std::thread>    threads_;
+
+    }; // class receiver_thread_pool
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <typename G>
+bcpp::message::receiver_thread_pool<G>::receiver_thread_pool
+(
+    configuration const & config,
+    work_contract_group & workContractGroup,
+    event_handlers eventHandlers
+):
+    config_(config),
+    workContractGroup_(workContractGroup),
+    pinFailureHandler_(std::move(eventHandlers.pinFailureHandler_))
+{
+    threads_.reserve(config_.threadCount_);
+    for (std::size_t i = 0; i < config_.threadCount_; ++i)
+        threads_.emplace_back([this, i](){run(i);});
+}
+
+
+//=============================================================================
+template <typename G>
+bcpp::message::receiver_thread_pool<G>::~receiver_thread_pool
+(
+)
+{
+    stop();
+}
+
+
+//=============================================================================
+template <typename G>
+void bcpp::message::receiver_thread_pool<G>::stop
+(
+)
+{
+    stopped_.store(true, std::memory_order_release);
+    for (auto & thread : threads_)
+        if (thread.joinable())
+            thread.join();
+}
+
+
+//=============================================================================
+template <typename G>
+bool bcpp::message::receiver_thread_pool<G>::pin_this_thread
+(
+    int cpu
+)
+{
+    return bcpp::system::set_cpu_affinity(bcpp::system::cpu_id(cpu));
+}
+
+
+//=============================================================================
+template <typename G>
+std::size_t bcpp::message::receiver_thread_pool<G>::get_pin_failure_count
+(
+) const
+{
+    return pinFailureCount_.load(std::memory_order_relaxed);
+}
+
+
+//=============================================================================
+template <typename G>
+void bcpp::message::receiver_thread_pool<G>::run
+(
+    std::size_t threadIndex
+)
+{
+    if (!config_.cpus_.empty())
+    {
+        if (auto cpu = config_.cpus_[threadIndex % config_.cpus_.size()]; !pin_this_thread(cpu))
+        {
+            pinFailureCount_.fetch_add(1, std::memory_order_relaxed);
+            if (pinFailureHandler_)
+                pinFailureHandler_(threadIndex, cpu);
+        }
+    }
+
+    while (!stopped_.load(std::memory_order_acquire))
+    {
+        if constexpr (requires (work_contract_group workContractGroup){workContractGroup.execute_next_contract(wait_timeout);})
+        {
+            workContractGroup_.execute_next_contract(wait_timeout);
+        }
+        else if constexpr (requires (work_contract_group workContractGroup){{workContractGroup.execute_next_contract()} -> std::convertible_to<bool>;})
+        {
+            if (!workContractGroup_.execute_next_contract())
+                std::this_thread::yield(); // nothing to do
+        }
+        else
+        {
+            workContractGroup_.execute_next_contract();
+        }
+    }
+}
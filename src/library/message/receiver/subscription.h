@@ -0,0 +1,135 @@
+#pragma once
+
+#include <library/message/protocol/protocol.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a set of the message types of protocol P.  usable at compile time (such as a target's static
+    // 'subscriptions' member which narrows the message types that the receiver dispatches) and at run time
+    // (receiver::subscribe() and friends).
+    template <protocol_concept P>
+    class subscription
+    {
+    public:
+
+        using protocol = P;
+        using message_indicator = typename protocol::message_indicator;
+
+        constexpr subscription() = default;
+
+        constexpr subscription
+        (
+            std::initializer_list<message_indicator> messageIndicators
+        )
+        {
+            for (auto messageIndicator : messageIndicators)
+                insert(messageIndicator);
+        }
+
+        // every message type of the protocol
+        static constexpr subscription all()
+        {
+            subscription result;
+            for (std::size_t i = 0; i < protocol::message_arity; ++i)
+                result.insert_index(i);
+            return result;
+        }
+
+        constexpr subscription & insert
+        (
+            message_indicator messageIndicator
+        )
+        {
+            if (auto index = protocol::index_of(messageIndicator); index < protocol::message_arity)
+                insert_index(index);
+            return *this;
+        }
+
+        constexpr subscription & erase
+        (
+            message_indicator messageIndicator
+        )
+        {
+            if (auto index = protocol::index_of(messageIndicator); index < protocol::message_arity)
+                bits_[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+            return *this;
+        }
+
+        constexpr bool contains
+        (
+            message_indicator messageIndicator
+        ) const
+        {
+            return contains_index(protocol::index_of(messageIndicator));
+        }
+
+        // by position within the protocol
+        constexpr bool contains_index
+        (
+            std::size_t index
+        ) const
+        {
+            return ((index < protocol::message_arity) && ((bits_[index / 64] & (std::uint64_t(1) << (index % 64))) != 0));
+        }
+
+        constexpr std::size_t size() const
+        {
+            std::size_t count = 0;
+            for (auto bits : bits_)
+                count += std::popcount(bits);
+            return count;
+        }
+
+        constexpr bool empty() const{return (size() == 0);}
+
+        constexpr subscription operator &
+        (
+            subscription const & other
+        ) const
+        {
+            subscription result;
+            for (std::size_t i = 0; i < bits_.size(); ++i)
+                result.bits_[i] = (bits_[i] & other.bits_[i]);
+            return result;
+        }
+
+        constexpr subscription operator |
+        (
+            subscription const & other
+        ) const
+        {
+            subscription result;
+            for (std::size_t i = 0; i < bits_.size(); ++i)
+                result.bits_[i] = (bits_[i] | other.bits_[i]);
+            return result;
+        }
+
+        constexpr bool operator ==
+        (
+            subscription const &
+        ) const = default;
+
+    private:
+
+        constexpr void insert_index
+        (
+            std::size_t index
+        )
+        {
+            bits_[index / 64] |= (std::uint64_t(1) << (index % 64));
+        }
+
+        std::array<std::uint64_t, ((protocol::message_arity + 63) / 64)> bits_{};
+
+    }; // class subscription
+
+} // namespace bcpp::message
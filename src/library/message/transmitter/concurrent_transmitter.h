@@ -0,0 +1,451 @@
+#pragma once
+
+#include <library/message/transport/packet.h>
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // transmitter which may be called by any number of threads at once (rather than wrapping a transmitter
+    // with a mutex).  a producer claims space for its message in the current packet with a single fetch_add
+    // on a word which holds both the packet's generation and the offset within it, constructs the message
+    // in place and then publishes it by adding its size to the packet's commit counter.
+    //
+    // the producer whose claim first overruns the packet seals it (at the offset it was given) and any
+    // producer which finds the packet overrun rolls the word over to the next packet of a ring of packets
+    // (no thread ever waits for another to roll over).  a sealed packet is handed to the packet handler once
+    // every claim within it has been committed.  hand off is done by a single flusher at a time: whichever
+    // thread completes a sealed packet (the last committer or the sealer) or calls flush().  the handlers
+    // are therefore never called concurrently but may be called by any producer thread.  producers only wait
+    // when every packet of the ring is sealed and not yet handed off (back pressure).
+    //
+    // messages never straddle packets and packets are handed off in order, although messages of different
+    // producers are interleaved in the order in which their space was claimed.  packet headroom, tracing and
+    // flush policies are not supported.  flush() before destruction.
+    template <protocol_concept P, packet_concept T, typename A = type_erased_handler, typename H = type_erased_handler>
+    class concurrent_transmitter final :
+        virtual non_copyable
+    {
+    public:
+
+        using packet_type = T;
+        using protocol = P;
+        using message_indicator = typename protocol::message_indicator;
+
+        static auto constexpr type_erased_packet_allocate_handler = std::is_same_v<A, type_erased_handler>;
+        static auto constexpr type_erased_packet_handler = std::is_same_v<H, type_erased_handler>;
+
+        static auto constexpr default_packet_capacity = ((1 << 10) * 2);
+        static auto constexpr default_ring_capacity = 8;
+
+        struct configuration
+        {
+            std::size_t packetCapacity_ = default_packet_capacity;
+            // packets which may be sealed but not yet handed off before producers are made to wait
+            std::size_t ringCapacity_ = default_ring_capacity;
+        };
+
+        using packet_allocate_handler = std::conditional_t<type_erased_packet_allocate_handler, std::function<packet_type(concurrent_transmitter const &, std::size_t)>, A>;
+        using packet_handler = std::conditional_t<type_erased_packet_handler, std::function<void(concurrent_transmitter const &, packet_type)>, H>;
+
+        struct event_handlers
+        {
+            packet_allocate_handler     packetAllocateHandler_;
+            packet_handler              packetHandler_;
+        };
+
+        concurrent_transmitter
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        // returns false if the message is larger than a packet
+        bool send
+        (
+            message_concept auto const & message
+        ) requires (std::is_same_v<protocol, typename std::decay_t<decltype(message)>::protocol>);
+
+        template <message_concept M, typename ... Ts>
+        bool emplace
+        (
+            Ts && ...
+        ) requires (std::is_same_v<protocol, typename M::protocol>);
+
+        // seal the current packet and hand off every packet which is complete.  a packet which still has
+        // claims outstanding is handed off by whichever producer commits the last of them.  any thread.
+        void flush();
+
+    private:
+
+        static auto constexpr cache_line_size = 64;
+        static auto constexpr offset_bits = 32;
+        static auto constexpr offset_mask = ((std::uint64_t(1) << offset_bits) - 1);
+        static auto constexpr not_sealed = std::numeric_limits<std::size_t>::max();
+
+        struct alignas(cache_line_size) slot
+        {
+            packet_type                 packet_;
+            std::uint8_t *              data_{nullptr};
+            std::atomic<std::uint32_t>  generation_{0};     // the generation which may claim space in this slot
+            std::atomic<std::size_t>    committed_{0};      // bytes of completed messages
+            std::atomic<std::size_t>    sealedSize_{not_sealed};
+        };
+
+        static packet_type default_packet_allocate_handler
+        (
+            concurrent_transmitter const &,
+            std::size_t
+        );
+
+        static constexpr std::uint32_t get_generation(std::uint64_t state){return static_cast<std::uint32_t>(state >> offset_bits);}
+
+        static constexpr std::size_t get_offset(std::uint64_t state){return static_cast<std::size_t>(state & offset_mask);}
+
+        static constexpr std::uint64_t make_state(std::uint32_t generation){return (std::uint64_t(generation) << offset_bits);}
+
+        slot & get_slot
+        (
+            std::uint32_t generation
+        )
+        {
+            return slots_[generation & mask_];
+        }
+
+        // claim 'size' bytes, call 'write' with their address and publish them.  returns false if the
+        // message is larger than a packet.
+        template <typename F>
+        bool claim
+        (
+            std::size_t,
+            F &&
+        );
+
+        // move the current packet, which is sealed, on to the next packet of the ring once that packet
+        // has been handed off.  returns once the generation has moved on (by this or any other thread).
+        void roll_over
+        (
+            std::uint32_t
+        );
+
+        void seal
+        (
+            std::uint32_t,
+            std::size_t
+        );
+
+        // prepare a slot to be claimed by the given generation
+        void reset
+        (
+            slot &,
+            std::uint32_t
+        );
+
+        bool is_complete
+        (
+            slot &
+        ) const;
+
+        // become the flusher (unless another thread is) and hand off every complete packet in order
+        void hand_off();
+
+        [[no_unique_address]] packet_allocate_handler   packetAllocateHandler_;
+
+        [[no_unique_address]] packet_handler            packetHandler_;
+
+        std::size_t                                     packetCapacity_;
+
+        std::size_t                                     mask_;
+
+        std::unique_ptr<slot []>                        slots_;
+
+        // producers' cache line: generation (high bits) and offset within the current packet (low bits)
+        alignas(cache_line_size) std::atomic<std::uint64_t> state_{0};
+
+        // flusher's cache line
+        alignas(cache_line_size) std::atomic<bool>      flushing_{false};
+
+        std::atomic<std::uint32_t>                      handOffGeneration_{0};  // next packet to hand off
+
+    }; // class concurrent_transmitter
+
+
+    //=========================================================================
+    // construct a concurrent_transmitter with statically bound handlers (typically lambdas)
+    template <protocol_concept P, packet_concept T, typename A, typename H>
+    auto make_concurrent_transmitter
+    (
+        typename concurrent_transmitter<P, T, std::decay_t<A>, std::decay_t<H>>::configuration const & config,
+        A && packetAllocateHandler,
+        H && packetHandler
+    ) -> std::unique_ptr<concurrent_transmitter<P, T, std::decay_t<A>, std::decay_t<H>>>
+    {
+        // heap allocated as it is neither copyable nor movable (producers hold references to it)
+        return std::make_unique<concurrent_transmitter<P, T, std::decay_t<A>, std::decay_t<H>>>(config,
+                typename concurrent_transmitter<P, T, std::decay_t<A>, std::decay_t<H>>::event_handlers{std::forward<A>(packetAllocateHandler), std::forward<H>(packetHandler)});
+    }
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bcpp::message::concurrent_transmitter<P, T, A, H>::concurrent_transmitter
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    packetAllocateHandler_(std::move(eventHandlers.packetAllocateHandler_)),
+    packetHandler_(std::move(eventHandlers.packetHandler_)),
+    packetCapacity_(std::min<std::size_t>(((config.packetCapacity_ == 0) ? default_packet_capacity : config.packetCapacity_), (offset_mask >> 1))),
+    mask_(std::bit_ceil(std::max<std::size_t>(config.ringCapacity_, 2)) - 1),
+    slots_(std::make_unique<slot []>(mask_ + 1))
+{
+    if constexpr (type_erased_packet_allocate_handler)
+        if (!packetAllocateHandler_)
+            packetAllocateHandler_ = default_packet_allocate_handler;
+    if constexpr (type_erased_packet_handler)
+        if (!packetHandler_)
+            packetHandler_ = [](auto const &, auto){};
+    for (std::uint32_t generation = 0; generation <= mask_; ++generation)
+        reset(get_slot(generation), generation);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+auto bcpp::message::concurrent_transmitter<P, T, A, H>::default_packet_allocate_handler
+(
+    concurrent_transmitter const &,
+    std::size_t capacity
+) -> packet_type
+{
+    if constexpr (requires (packet_type packet){packet.reserve(capacity);})
+    {
+        packet_type packet;
+        packet.reserve(capacity);
+        return packet;
+    }
+    else
+    {
+        return packet_type(capacity);
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::concurrent_transmitter<P, T, A, H>::reset
+(
+    slot & s,
+    std::uint32_t generation
+)
+{
+    // producers write directly into the packet's storage so size it to its full capacity up front
+    s.packet_ = packetAllocateHandler_(*this, packetCapacity_);
+    if constexpr (requires (packet_type packet){packet.resize_uninitialized(packetCapacity_);})
+        s.packet_.resize_uninitialized(packetCapacity_);
+    else
+        s.packet_.resize(packetCapacity_);
+    s.data_ = reinterpret_cast<std::uint8_t *>(s.packet_.data());
+    s.committed_.store(0, std::memory_order_relaxed);
+    s.sealedSize_.store(not_sealed, std::memory_order_relaxed);
+    s.generation_.store(generation, std::memory_order_release);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bool bcpp::message::concurrent_transmitter<P, T, A, H>::send
+(
+    message_concept auto const & message
+) requires (std::is_same_v<protocol, typename std::decay_t<decltype(message)>::protocol>)
+{
+    auto size = message.size();
+    return claim(size, [&](std::uint8_t * address){std::copy_n(reinterpret_cast<std::uint8_t const *>(&message), size, address);});
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+template <bcpp::message::message_concept M, typename ... Ts>
+bool bcpp::message::concurrent_transmitter<P, T, A, H>::emplace
+(
+    Ts && ... args
+) requires (std::is_same_v<protocol, typename M::protocol>)
+{
+    // as transmitter::emplace(), only messages with a static size() can be constructed in place
+    if constexpr (requires (){M::size(args ...);})
+        return claim(M::size(args ...), [&](std::uint8_t * address){new (address) M(std::forward<Ts>(args) ...);});
+    else if constexpr (requires (){M::size();})
+        return claim(M::size(), [&](std::uint8_t * address){new (address) M(std::forward<Ts>(args) ...);});
+    else
+        return send(M(std::forward<Ts>(args) ...));
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+template <typename F>
+bool bcpp::message::concurrent_transmitter<P, T, A, H>::claim
+(
+    std::size_t size,
+    F && write
+)
+{
+    if (size > packetCapacity_)
+        return false;
+    auto state = state_.load(std::memory_order_acquire);
+    while (true)
+    {
+        if (get_offset(state) > packetCapacity_)
+        {
+            // the packet has been overrun (and sealed).  help move on to the next packet.
+            roll_over(get_generation(state));
+            state = state_.load(std::memory_order_acquire);
+            continue;
+        }
+        // the claim applies to whichever packet is current by now (not necessarily the one just observed)
+        state = state_.fetch_add(size, std::memory_order_acq_rel);
+        auto generation = get_generation(state);
+        auto offset = get_offset(state);
+        auto & s = get_slot(generation);
+        if ((offset + size) <= packetCapacity_)
+        {
+            write(s.data_ + offset);
+            if ((s.committed_.fetch_add(size) + size) == s.sealedSize_.load())
+                hand_off(); // last claim of a sealed packet
+            return true;
+        }
+        if (offset <= packetCapacity_)
+            seal(generation, offset); // the first claim to overrun the packet
+        roll_over(generation);
+        state = state_.load(std::memory_order_acquire);
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::concurrent_transmitter<P, T, A, H>::seal
+(
+    std::uint32_t generation,
+    std::size_t size
+)
+{
+    auto & s = get_slot(generation);
+    s.sealedSize_.store(size);
+    if (s.committed_.load() == size)
+        hand_off(); // every claim has already been committed
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::concurrent_transmitter<P, T, A, H>::roll_over
+(
+    std::uint32_t generation
+)
+{
+    auto const nextGeneration = static_cast<std::uint32_t>(generation + 1);
+    auto state = state_.load(std::memory_order_acquire);
+    while (get_generation(state) == generation)
+    {
+        if (get_slot(nextGeneration).generation_.load(std::memory_order_acquire) != nextGeneration)
+        {
+            // every packet of the ring is awaiting hand off
+            std::this_thread::yield();
+            state = state_.load(std::memory_order_acquire);
+            continue;
+        }
+        if (state_.compare_exchange_weak(state, make_state(nextGeneration), std::memory_order_acq_rel, std::memory_order_acquire))
+            return;
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bool bcpp::message::concurrent_transmitter<P, T, A, H>::is_complete
+(
+    slot & s
+) const
+{
+    auto sealedSize = s.sealedSize_.load();
+    return ((sealedSize != not_sealed) && (s.committed_.load() == sealedSize));
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::concurrent_transmitter<P, T, A, H>::hand_off
+(
+)
+{
+    // the flag and counters use sequentially consistent operations so that a thread which completes a
+    // packet while another holds the flusher role either takes the role itself or has its packet seen by
+    // the flusher's check after releasing the role
+    while (!flushing_.exchange(true))
+    {
+        auto generation = handOffGeneration_.load(std::memory_order_relaxed);
+        for (auto * s = &get_slot(generation); ((s->generation_.load(std::memory_order_relaxed) == generation) && (is_complete(*s))); s = &get_slot(++generation))
+        {
+            if (auto sealedSize = s->sealedSize_.load(); sealedSize > 0)
+            {
+                s->packet_.resize(sealedSize); // shrink to the bytes claimed
+                packetHandler_(*this, std::move(s->packet_));
+            }
+            reset(*s, static_cast<std::uint32_t>(generation + mask_ + 1));
+        }
+        handOffGeneration_.store(generation, std::memory_order_relaxed);
+        flushing_.store(false);
+        auto & next = get_slot(generation);
+        if ((next.generation_.load(std::memory_order_relaxed) != generation) || (!is_complete(next)))
+            return;
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::concurrent_transmitter<P, T, A, H>::flush
+(
+)
+{
+    auto state = state_.load(std::memory_order_acquire);
+    while ((get_offset(state) > 0) && (get_offset(state) <= packetCapacity_))
+    {
+        // seal the current packet at its present size by moving on to the next packet
+        auto generation = get_generation(state);
+        auto const nextGeneration = static_cast<std::uint32_t>(generation + 1);
+        if (get_slot(nextGeneration).generation_.load(std::memory_order_acquire) != nextGeneration)
+        {
+            hand_off();
+            std::this_thread::yield();
+            state = state_.load(std::memory_order_acquire);
+            continue;
+        }
+        if (state_.compare_exchange_weak(state, make_state(nextGeneration), std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            seal(generation, get_offset(state));
+            break;
+        }
+    }
+    // an overrun packet has been sealed by the producer which overran it
+    hand_off();
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "./transmitter.h"
+
+#include <include/non_copyable.h>
+
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // the outbound lane of a message type.  a message type selects a lane other than lane zero by declaring
+    //      static auto constexpr lane = N;
+    template <message_concept M>
+    static auto constexpr lane_of = []()
+            {
+                if constexpr (requires {{M::lane} -> std::convertible_to<std::size_t>;})
+                    return static_cast<std::size_t>(M::lane);
+                else
+                    return std::size_t(0);
+            }();
+
+
+    //=========================================================================
+    // a transmitter with N outbound lanes, each a transmitter of its own with its own packet and flush
+    // policy, so that urgent messages (cancels, heartbeats) never wait behind a packet of bulk traffic.
+    // each message is sent via the lane selected (at compile time) by lane_of.  typically lane zero batches
+    // bulk traffic into full packets while an urgent lane flushes every message (flushPolicy_.maxMessages_
+    // = 1) or on a tight deadline (flushPolicy_.maxAge_ enforced by poll()).  the packet handler is told the
+    // lane of each packet so that the transport can prioritize it too.
+    //
+    // ordering is only preserved within a lane.  not thread safe.
+    template <protocol_concept P, packet_concept T, std::size_t N>
+    class lane_transmitter :
+        non_copyable
+    {
+    public:
+
+        using protocol = P;
+        using packet_type = T;
+
+        static auto constexpr lane_count = N;
+
+        struct lane_packet_binding;
+
+        using lane_transmitter_type = transmitter<P, T, type_erased_handler, lane_packet_binding>;
+        using clock = typename lane_transmitter_type::clock;
+
+        // receives each flushed packet along with its lane
+        using packet_handler = std::function<void(std::size_t, packet_type)>;
+
+        struct configuration
+        {
+            std::array<typename lane_transmitter_type::configuration, N> laneConfigurations_{};
+        };
+
+        struct event_handlers
+        {
+            typename lane_transmitter_type::packet_allocate_handler packetAllocateHandler_;
+            packet_handler                                          packetHandler_;
+        };
+
+        // hands each of a lane's packets to the lane transmitter's packet handler
+        struct lane_packet_binding
+        {
+            void operator()
+            (
+                lane_transmitter_type const &,
+                packet_type packet
+            ) const
+            {
+                if (laneTransmitter_->packetHandler_)
+                    laneTransmitter_->packetHandler_(lane_, std::move(packet));
+            }
+
+            lane_transmitter *  laneTransmitter_;
+            std::size_t         lane_;
+        };
+
+        lane_transmitter
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        lane_transmitter(lane_transmitter &&) = delete;
+        lane_transmitter & operator = (lane_transmitter &&) = delete;
+
+        bool send
+        (
+            message_concept auto const & message
+        ) requires (std::is_same_v<protocol, typename std::decay_t<decltype(message)>::protocol>);
+
+        template <message_concept M, typename ... Ts>
+        bool emplace
+        (
+            Ts && ...
+        ) requires (std::is_same_v<protocol, typename M::protocol>);
+
+        // flush every lane, highest lane first (by convention the more urgent lanes are the higher lanes)
+        void flush();
+
+        void flush
+        (
+            std::size_t
+        );
+
+        // enforce each lane's age trigger.  returns true if any lane was flushed.
+        bool poll
+        (
+            clock::time_point = clock::now()
+        );
+
+        lane_transmitter_type & get_lane
+        (
+            std::size_t
+        );
+
+    private:
+
+        packet_handler                                      packetHandler_;
+
+        // held by pointer as each lane's packet handler refers back to this lane_transmitter
+        std::array<std::unique_ptr<lane_transmitter_type>, N> lanes_;
+
+    }; // class lane_transmitter
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+bcpp::message::lane_transmitter<P, T, N>::lane_transmitter
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    packetHandler_(std::move(eventHandlers.packetHandler_))
+{
+    static_assert(N > 0, "a lane_transmitter requires at least one lane");
+    for (std::size_t lane = 0; lane < N; ++lane)
+        lanes_[lane] = std::make_unique<lane_transmitter_type>(config.laneConfigurations_[lane],
+                typename lane_transmitter_type::event_handlers{eventHandlers.packetAllocateHandler_, lane_packet_binding{this, lane}});
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+bool bcpp::message::lane_transmitter<P, T, N>::send
+(
+    message_concept auto const & message
+) requires (std::is_same_v<protocol, typename std::decay_t<decltype(message)>::protocol>)
+{
+    static auto constexpr lane = lane_of<std::decay_t<decltype(message)>>;
+    static_assert(lane < N, "message type selects a lane beyond the lane count");
+    return lanes_[lane]->send(message);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+template <bcpp::message::message_concept M, typename ... Ts>
+bool bcpp::message::lane_transmitter<P, T, N>::emplace
+(
+    Ts && ... args
+) requires (std::is_same_v<protocol, typename M::protocol>)
+{
+    static_assert(lane_of<M> < N, "message type selects a lane beyond the lane count");
+    return lanes_[lane_of<M>]->template emplace<M>(std::forward<Ts>(args) ...);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+void bcpp::message::lane_transmitter<P, T, N>::flush
+(
+)
+{
+    for (auto lane = N; lane-- > 0; )
+        lanes_[lane]->flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+void bcpp::message::lane_transmitter<P, T, N>::flush
+(
+    std::size_t lane
+)
+{
+    if (lane < N)
+        lanes_[lane]->flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+bool bcpp::message::lane_transmitter<P, T, N>::poll
+(
+    clock::time_point now
+)
+{
+    bool flushed = false;
+    for (auto lane = N; lane-- > 0; )
+        flushed |= lanes_[lane]->poll(now);
+    return flushed;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, std::size_t N>
+auto bcpp::message::lane_transmitter<P, T, N>::get_lane
+(
+    std::size_t lane
+) -> lane_transmitter_type &
+{
+    return *lanes_[lane];
+}
@@ -1,15 +1,27 @@
 #pragma once
 
+#include <library/message/instrumentation/instrumentation.h>
+#include <library/message/instrumentation/trace.h>
+
 #include <include/non_copyable.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
 
 
 namespace bcpp::message 
 {
 
-    template <protocol_concept P, packet_concept T>
+    template <protocol_concept P, packet_concept T, typename A = type_erased_handler, typename H = type_erased_handler>
     class transmitter final :
         virtual non_copyable
     {
@@ -17,16 +29,47 @@ namespace bcpp::message
 
         using packet_type = T;
         using protocol = P;
+        using message_indicator = typename protocol::message_indicator;
+
+        // handlers are either type erased (std::function) or statically bound callables (A and H) which 
+        // can be inlined into send(), emplace() and flush()
+        static auto constexpr type_erased_packet_allocate_handler = std::is_same_v<A, type_erased_handler>;
+        static auto constexpr type_erased_packet_handler = std::is_same_v<H, type_erased_handler>;
 
         static auto constexpr default_packet_capacity = ((1 << 10) * 2);
 
+        using clock = std::chrono::steady_clock;
+
+        // conditions under which the current packet is flushed automatically (in addition to flushing when a
+        // message does not fit).  a value of zero disables the corresponding trigger.  the byte and message
+        // triggers are checked as each message is buffered.  the age trigger is measured from the first
+        // message buffered in the current packet and is enforced by poll().  with a batching packet handler
+        // the byte and message triggers only hand the packet to the batch while the age trigger also 
+        // delivers the batch.
+        struct flush_policy
+        {
+            std::size_t                 maxBytes_{0};
+            std::size_t                 maxMessages_{0};
+            std::chrono::nanoseconds    maxAge_{0};
+            // tune the effective packet size (bounded by maxBytes_ and the packet capacity) to the observed
+            // send rate so that a packet fills in roughly maxAge_.  low rates flush small packets promptly 
+            // while high rates grow toward full packets.  requires maxAge_.
+            bool                        adaptive_{false};
+        };
+
         struct configuration
         {
             std::size_t packetCapacity_ = default_packet_capacity;
+            flush_policy flushPolicy_;
+            // begin every packet with a packet_trace (the receiver must be configured likewise)
+            bool tracePackets_{false};
+            // bytes reserved (zero filled) at the very start of every packet for an outer framing layer
+            // such as the sequencer's sequence_header (the receiver must be configured likewise)
+            std::size_t packetHeadroom_{0};
         };
 
-        using packet_allocate_handler = std::function<packet_type(transmitter const &, std::size_t)>;
-        using packet_handler = std::function<void(transmitter const &, packet_type)>;
+        using packet_allocate_handler = std::conditional_t<type_erased_packet_allocate_handler, std::function<packet_type(transmitter const &, std::size_t)>, A>;
+        using packet_handler = std::conditional_t<type_erased_packet_handler, std::function<void(transmitter const &, packet_type)>, H>;
 
         struct event_handlers
         {
@@ -34,10 +77,26 @@ namespace bcpp::message
             packet_handler              packetHandler_;
         };
 
+        struct message_statistics
+        {
+            message_indicator           messageIndicator_{};
+            std::size_t                 messages_{0};
+            std::size_t                 bytes_{0};
+        };
+
+        // snapshot of the hot path statistics.  only collected when instrumentation_enabled.
+        struct statistics
+        {
+            std::array<message_statistics, protocol::message_arity> messages_{};
+            std::size_t                 flushes_{0};            // non empty packets handed to the packet handler
+            std::size_t                 bytesFlushed_{0};
+            double                      averageFillRatio_{0.0}; // bytes flushed relative to packet capacity
+        };
+
         transmitter
         (
             configuration const &,
-            event_handlers const &
+            event_handlers
         );
 
         bool send
@@ -51,57 +110,231 @@ namespace bcpp::message
             Ts && ...
         ) requires (std::is_same_v<protocol, typename M::protocol>);
 
+        // reserve space for a message of type M directly within the current packet (flushing first if
+        // required) and construct M in place at the start of that space.  the caller then serializes any
+        // variable length portion of the message in place and calls commit() with the actual size of the 
+        // message.  returns nullptr if the space can not be reserved (or exceeds the largest size which the
+        // message header can declare).  the reservation must be committed
+        // (or cancelled) before any other message is sent or the transmitter is flushed.
+        template <message_concept M, typename ... Ts>
+        M * reserve
+        (
+            std::size_t,
+            Ts && ...
+        ) requires (std::is_same_v<protocol, typename M::protocol>);
+
+        // complete the reserved message.  the unused portion of the reservation is returned to the packet
+        // and the message header's size is updated (the header must provide set_size()).  returns false if
+        // there is no reservation or the size is either smaller than M, exceeds the reservation or exceeds
+        // the largest size which the message header can declare.
+        bool commit
+        (
+            std::size_t
+        );
+
+        void cancel();
+
+        // hand the current packet to the packet handler.  if the packet handler batches packets (such as
+        // packet_batcher) the batch is delivered as well.
         void flush();
 
+        // reference an externally owned payload in the outgoing stream without copying it into a packet.
+        // the current packet is handed off first so that ordering is preserved.  the payload must remain 
+        // valid until the packet handler delivers it.  only available with packet handlers which support
+        // attach() (such as packet_batcher).  not compatible with packet tracing or headroom.
+        void attach
+        (
+            std::span<char const>
+        ) requires (requires (packet_handler packetHandler, std::span<char const> payload){packetHandler.attach(payload);});
+
+        // enforce the flush policy's age trigger.  cheap enough to call from a busy loop or timer.
+        // returns true if the current packet was flushed.
+        bool poll
+        (
+            clock::time_point = clock::now()
+        );
+
+        // returns an empty snapshot if instrumentation is disabled
+        statistics get_statistics() const;
+
     private:
 
-        packet_allocate_handler     packetAllocateHandler_;
+        static auto constexpr adaptive_smoothing_factor = 8; // weight of each rate sample is 1/8
+
+        // the largest size which the message header can declare.  a function rather than a constant as 
+        // the message header need not be complete when the transmitter is named.
+        static constexpr std::size_t max_message_size()
+        {
+            using size_type = std::decay_t<decltype(std::declval<message_header<protocol> const &>().size())>;
+            return static_cast<std::size_t>(std::numeric_limits<size_type>::max());
+        }
+
+        static packet_type default_packet_allocate_handler
+        (
+            transmitter const &,
+            std::size_t
+        );
+
+        // grow the current packet and return the address of the new space.  packet types which support
+        // resize_uninitialized() (such as aligned_packet) are grown without zero filling.
+        std::uint8_t * append
+        (
+            std::size_t
+        );
+
+        // hand the current packet to the packet handler and start a new one.  unlike flush(), a batching 
+        // packet handler is left to deliver the batch when it sees fit.
+        void rotate();
+
+        // count a newly buffered message and flush if it trips the byte or message trigger.  the message
+        // is identified by its index within the protocol.
+        void on_message_buffered
+        (
+            std::size_t,
+            std::size_t
+        );
+
+        void update_send_rate
+        (
+            clock::time_point
+        );
+
+        [[no_unique_address]] packet_allocate_handler     packetAllocateHandler_;
 
-        packet_handler              packetHandler_;
+        [[no_unique_address]] packet_handler              packetHandler_;
 
         std::size_t                 packetCapacity_;
 
         packet_type                 packet_;
 
+        std::size_t                 reservedOffset_{0};
+
+        std::size_t                 reservedSize_{0};
+
+        std::size_t                 reservedMinimumSize_{0};    // sizeof the reserved message type
+
+        flush_policy                flushPolicy_;
+
+        bool                        timed_;             // age or adaptive trigger requires timestamps
+
+        std::size_t                 maxBytes_;          // effective byte trigger (tuned if adaptive)
+
+        std::size_t                 maxMessages_;
+
+        std::size_t                 messageCount_{0};
+
+        clock::time_point           firstMessageTime_;
+
+        clock::time_point           lastFlushTime_;
+
+        double                      sendRate_{0.0};     // bytes per nanosecond (adaptive only)
+
+        std::size_t                 reservedIndex_{0};  // protocol index of the reserved message
+
+        std::size_t                 packetHeadroom_;
+
+        bool                        tracePackets_;
+
+        std::size_t                 packetPrefixSize_;  // headroom plus the trace prefix (if tracing)
+
+        [[no_unique_address]] std::conditional_t<instrumentation_enabled, statistics, no_statistics> statistics_;
+
     }; // class transmitter
 
+
+    //=========================================================================
+    // construct a transmitter with statically bound handlers (typically lambdas)
+    template <protocol_concept P, packet_concept T, typename A, typename H>
+    auto make_transmitter
+    (
+        typename transmitter<P, T, std::decay_t<A>, std::decay_t<H>>::configuration const & config,
+        A && packetAllocateHandler,
+        H && packetHandler
+    ) -> transmitter<P, T, std::decay_t<A>, std::decay_t<H>>
+    {
+        return {config, {std::forward<A>(packetAllocateHandler), std::forward<H>(packetHandler)}};
+    }
+
 } // namespace bcpp::message
 
 
 //=============================================================================
-template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T>
-bcpp::message::transmitter<P, T>::transmitter
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bcpp::message::transmitter<P, T, A, H>::transmitter
 (
     configuration const & config,
-    event_handlers const & eventHandlers
+    event_handlers eventHandlers
 ):
-    packetAllocateHandler_(eventHandlers.packetAllocateHandler_ ? eventHandlers.packetAllocateHandler_ : [](auto const &, std::size_t capacity){return packet_type(capacity);}),
-    packetHandler_(eventHandlers.packetHandler_ ? eventHandlers.packetHandler_ : [](auto const &, auto){}),
-    packetCapacity_((config.packetCapacity_ == 0) ? config.packetCapacity_ : default_packet_capacity)
+    packetAllocateHandler_(std::move(eventHandlers.packetAllocateHandler_)),
+    packetHandler_(std::move(eventHandlers.packetHandler_)),
+    packetCapacity_((config.packetCapacity_ == 0) ? default_packet_capacity : config.packetCapacity_),
+    flushPolicy_(config.flushPolicy_),
+    timed_(flushPolicy_.maxAge_.count() > 0),
+    maxBytes_((flushPolicy_.maxBytes_ == 0) ? packetCapacity_ : std::min(flushPolicy_.maxBytes_, packetCapacity_)),
+    maxMessages_((flushPolicy_.maxMessages_ == 0) ? std::numeric_limits<std::size_t>::max() : flushPolicy_.maxMessages_),
+    lastFlushTime_(timed_ ? clock::now() : clock::time_point()),
+    packetHeadroom_(config.packetHeadroom_),
+    tracePackets_(config.tracePackets_),
+    packetPrefixSize_(packetHeadroom_ + (tracePackets_ ? sizeof(packet_trace) : 0))
 {
+    flushPolicy_.adaptive_ &= timed_;
+    if constexpr (instrumentation_enabled)
+        for (std::size_t i = 0; i < protocol::message_arity; ++i)
+            statistics_.messages_[i].messageIndicator_ = protocol::get(i);
+    if constexpr (type_erased_packet_allocate_handler)
+        if (!packetAllocateHandler_)
+            packetAllocateHandler_ = default_packet_allocate_handler;
+    if constexpr (type_erased_packet_handler)
+        if (!packetHandler_)
+            packetHandler_ = [](auto const &, auto){};
+    if (packetPrefixSize_ != 0)
+        rotate(); // start with a packet which carries the prefix
 }
 
 
 //=============================================================================
-template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T>
-bool bcpp::message::transmitter<P, T>::send
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+auto bcpp::message::transmitter<P, T, A, H>::default_packet_allocate_handler
+(
+    transmitter const &,
+    std::size_t capacity
+) -> packet_type
+{
+    if constexpr (requires (packet_type packet){packet.reserve(capacity);})
+    {
+        // containers such as std::vector interpret a size argument as the initial size rather than capacity
+        packet_type packet;
+        packet.reserve(capacity);
+        return packet;
+    }
+    else
+    {
+        return packet_type(capacity);
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bool bcpp::message::transmitter<P, T, A, H>::send
 (
     message_concept auto const & message
 ) requires (std::is_same_v<protocol, typename std::decay_t<decltype(message)>::protocol>)
 {
+    static auto constexpr message_index = protocol::index_of(std::decay_t<decltype(message)>::type);
     auto spaceRequired = message.size();
     if (auto spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining >= spaceRequired)
     {
-        packet_.resize(packet_.size() + spaceRequired);
-        std::copy_n(reinterpret_cast<std::uint8_t const *>(&message), spaceRequired, packet_.end() - spaceRequired);
+        std::copy_n(reinterpret_cast<std::uint8_t const *>(&message), spaceRequired, append(spaceRequired));
+        on_message_buffered(message_index, spaceRequired);
         return true;
     }
 
-    flush();
+    rotate();
     if (auto spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining >= spaceRequired)
     {
-        packet_.resize(packet_.size() + spaceRequired);
-        std::copy_n(reinterpret_cast<std::uint8_t const *>(&message), spaceRequired, packet_.end() - spaceRequired);
+        std::copy_n(reinterpret_cast<std::uint8_t const *>(&message), spaceRequired, append(spaceRequired));
+        on_message_buffered(message_index, spaceRequired);
         return true;
     }
     return false;
@@ -109,9 +342,9 @@ bool bcpp::message::transmitter<P, T>::send
 
 
 //=============================================================================
-template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T>
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
 template <bcpp::message::message_concept M, typename ... Ts>
-bool bcpp::message::transmitter<P, T>::emplace
+bool bcpp::message::transmitter<P, T, A, H>::emplace
 (
     // use placement new if possible
     Ts && ... args
@@ -122,7 +355,7 @@ bool bcpp::message::transmitter<P, T>::emplace
         // emplace requires that the message's size() function be static and accepts the provided arguments.
         // This basiclly means that to embed a message, its size must be calculable without requiring 
         // consturction of the message.  Anything else defeats the point of an optimized emplace call entirely.
-        auto spaceRequired = 0;
+        std::size_t spaceRequired = 0;
         if constexpr (requires (){M::size(args ...);})
             spaceRequired = M::size(args ...); // has a ctor that takes the provided args
         else
@@ -130,16 +363,16 @@ bool bcpp::message::transmitter<P, T>::emplace
 
         if (auto spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining >= spaceRequired)
         {
-            packet_.resize(packet_.size() + spaceRequired);
-            new (&*packet_.end() - spaceRequired) M(std::forward<Ts>(args) ...);
+            new (append(spaceRequired)) M(std::forward<Ts>(args) ...);
+            on_message_buffered(protocol::index_of(M::type), spaceRequired);
             return true;
         }
 
-        flush();
+        rotate();
         if (auto spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining >= spaceRequired)
         {
-            packet_.resize(packet_.size() + spaceRequired);
-            new (&*packet_.end() - spaceRequired) M(std::forward<Ts>(args) ...);
+            new (append(spaceRequired)) M(std::forward<Ts>(args) ...);
+            on_message_buffered(protocol::index_of(M::type), spaceRequired);
             return true;
         }
         return false;
@@ -154,12 +387,213 @@ bool bcpp::message::transmitter<P, T>::emplace
 
 
 //=============================================================================
-template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T>
-void bcpp::message::transmitter<P, T>::flush
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+template <bcpp::message::message_concept M, typename ... Ts>
+M * bcpp::message::transmitter<P, T, A, H>::reserve
+(
+    std::size_t capacity,
+    Ts && ... args
+) requires (std::is_same_v<protocol, typename M::protocol>)
+{
+    capacity = std::max(capacity, sizeof(M));
+    if (capacity > max_message_size())
+        return nullptr; // the message header could not declare the size of the message
+    if (auto spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining < capacity)
+    {
+        rotate();
+        if (spaceRemaining = (packet_.capacity() - packet_.size()); spaceRemaining < capacity)
+            return nullptr;
+    }
+    reservedOffset_ = packet_.size();
+    reservedSize_ = capacity;
+    reservedMinimumSize_ = sizeof(M);
+    reservedIndex_ = protocol::index_of(M::type);
+    return new (append(capacity)) M(std::forward<Ts>(args) ...);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bool bcpp::message::transmitter<P, T, A, H>::commit
+(
+    std::size_t size
+)
+{
+    using message_header = message_header<protocol>;
+
+    static_assert(requires (message_header messageHeader){messageHeader.set_size(size);}, 
+            "reserve/commit requires message_header to provide set_size() so the header declares the committed size");
+
+    if ((reservedSize_ == 0) || (size > reservedSize_) || (size < reservedMinimumSize_) || (size > max_message_size()))
+        return false;
+    reinterpret_cast<message_header *>(packet_.data() + reservedOffset_)->set_size(size);
+    packet_.resize(reservedOffset_ + size); // shrink
+    reservedSize_ = 0;
+    on_message_buffered(reservedIndex_, size);
+    return true;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::cancel
 (
 )
 {
-    if (!packet_.empty())
+    if (reservedSize_ > 0)
+        packet_.resize(reservedOffset_);
+    reservedSize_ = 0;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::flush
+(
+)
+{
+    rotate();
+    if constexpr (requires (packet_handler packetHandler){packetHandler.flush();})
+        packetHandler_.flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::attach
+(
+    std::span<char const> payload
+) requires (requires (packet_handler packetHandler, std::span<char const> payload){packetHandler.attach(payload);})
+{
+    if (packet_.size() > packetPrefixSize_)
+        rotate();
+    packetHandler_.attach(payload);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::rotate
+(
+)
+{
+    if (packet_.size() > packetPrefixSize_)
+    {
+        if (tracePackets_)
+        {
+            auto flushedTime = trace_time();
+            std::memcpy(packet_.data() + packetHeadroom_ + offsetof(packet_trace, flushedTime_), &flushedTime, sizeof(flushedTime));
+        }
+        if (flushPolicy_.adaptive_)
+            update_send_rate(clock::now());
+        if constexpr (instrumentation_enabled)
+        {
+            ++statistics_.flushes_;
+            statistics_.bytesFlushed_ += packet_.size();
+        }
         packetHandler_(*this, std::move(packet_));
+    }
     packet_ = packetAllocateHandler_(*this, packetCapacity_);
+    if (packetPrefixSize_ != 0)
+        std::fill_n(append(packetPrefixSize_), packetPrefixSize_, 0);
+    messageCount_ = 0;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+bool bcpp::message::transmitter<P, T, A, H>::poll
+(
+    clock::time_point now
+)
+{
+    if ((messageCount_ == 0) || (!timed_) || (reservedSize_ > 0) || ((now - firstMessageTime_) < flushPolicy_.maxAge_))
+        return false;
+    flush();
+    return true;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::on_message_buffered
+(
+    [[maybe_unused]] std::size_t messageIndex,
+    [[maybe_unused]] std::size_t messageSize
+)
+{
+    if constexpr (instrumentation_enabled)
+    {
+        ++statistics_.messages_[messageIndex].messages_;
+        statistics_.messages_[messageIndex].bytes_ += messageSize;
+    }
+    if (++messageCount_ == 1)
+    {
+        if (timed_)
+            firstMessageTime_ = clock::now();
+        if (tracePackets_)
+        {
+            auto bufferedTime = trace_time();
+            std::memcpy(packet_.data() + packetHeadroom_ + offsetof(packet_trace, bufferedTime_), &bufferedTime, sizeof(bufferedTime));
+        }
+    }
+    if ((packet_.size() >= maxBytes_) || (messageCount_ >= maxMessages_))
+        rotate();
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+void bcpp::message::transmitter<P, T, A, H>::update_send_rate
+(
+    clock::time_point now
+)
+{
+    // the rate is measured over the interval since the previous flush rather than since the first 
+    // buffered message so that single message packets (low rates) still yield a meaningful sample
+    auto elapsed = std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastFlushTime_).count(), 1);
+    lastFlushTime_ = now;
+    auto sample = (static_cast<double>(packet_.size()) / elapsed);
+    sendRate_ += ((sample - sendRate_) / adaptive_smoothing_factor);
+
+    // size packets to fill in roughly maxAge_ at the current rate
+    auto upperBound = ((flushPolicy_.maxBytes_ == 0) ? packetCapacity_ : std::min(flushPolicy_.maxBytes_, packetCapacity_));
+    auto target = (sendRate_ * flushPolicy_.maxAge_.count());
+    maxBytes_ = (target >= upperBound) ? upperBound : std::max<std::size_t>(static_cast<std::size_t>(target), 1);
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+std::uint8_t * bcpp::message::transmitter<P, T, A, H>::append
+(
+    std::size_t size
+)
+{
+    auto currentSize = packet_.size();
+    if constexpr (requires (packet_type packet){packet.resize_uninitialized(size);})
+        packet_.resize_uninitialized(currentSize + size);
+    else
+        packet_.resize(currentSize + size);
+    return reinterpret_cast<std::uint8_t *>(packet_.data()) + currentSize;
+}
+
+
+//=============================================================================
+template <bcpp::message::protocol_concept P, bcpp::message::packet_concept T, typename A, typename H>
+auto bcpp::message::transmitter<P, T, A, H>::get_statistics
+(
+) const -> statistics
+{
+    if constexpr (instrumentation_enabled)
+    {
+        auto snapshot = statistics_;
+        if (snapshot.flushes_ > 0)
+            snapshot.averageFillRatio_ = (static_cast<double>(snapshot.bytesFlushed_) / (snapshot.flushes_ * packetCapacity_));
+        return snapshot;
+    }
+    else
+    {
+        return {};
+    }
 }
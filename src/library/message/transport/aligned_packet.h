@@ -0,0 +1,174 @@
+#pragma once
+
+#include "./packet.h"
+#include "./packet_arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a packet whose storage is 64 byte aligned and allocated from the calling thread's packet_arena.
+    // unlike std::vector<char> it supports growth without initializing the new bytes (resize_uninitialized)
+    // which transmitter uses in place of resize() when serializing messages.
+    class aligned_packet
+    {
+    public:
+
+        using value_type = char;
+        using size_type = std::size_t;
+        using iterator = char *;
+        using const_iterator = char const *;
+
+        aligned_packet() = default;
+
+        // NOTE: unlike std::vector the argument is the capacity, not the size
+        explicit aligned_packet
+        (
+            std::size_t capacity
+        )
+        {
+            reserve(capacity);
+        }
+
+        aligned_packet
+        (
+            aligned_packet const & other
+        )
+        {
+            reserve(other.size_);
+            if (other.size_ > 0)
+                std::memcpy(data_, other.data_, other.size_);
+            size_ = other.size_;
+        }
+
+        aligned_packet
+        (
+            aligned_packet && other
+        ) noexcept :
+            data_(std::exchange(other.data_, nullptr)),
+            size_(std::exchange(other.size_, 0)),
+            capacity_(std::exchange(other.capacity_, 0))
+        {
+        }
+
+        aligned_packet & operator =
+        (
+            aligned_packet const & other
+        )
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.size_);
+                if (other.size_ > 0)
+                    std::memcpy(data_, other.data_, other.size_);
+                size_ = other.size_;
+            }
+            return *this;
+        }
+
+        aligned_packet & operator =
+        (
+            aligned_packet && other
+        ) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+                capacity_ = std::exchange(other.capacity_, 0);
+            }
+            return *this;
+        }
+
+        ~aligned_packet()
+        {
+            release();
+        }
+
+        char * data(){return data_;}
+        char const * data() const{return data_;}
+
+        iterator begin(){return data_;}
+        const_iterator begin() const{return data_;}
+
+        iterator end(){return data_ + size_;}
+        const_iterator end() const{return data_ + size_;}
+
+        std::size_t size() const{return size_;}
+
+        bool empty() const{return (size_ == 0);}
+
+        std::size_t capacity() const{return capacity_;}
+
+        void clear(){size_ = 0;}
+
+        void reserve
+        (
+            std::size_t capacity
+        )
+        {
+            if (capacity <= capacity_)
+                return;
+            auto data = reinterpret_cast<char *>(packet_arena::this_thread().allocate(capacity));
+            auto size = size_;
+            if (size > 0)
+                std::memcpy(data, data_, size);
+            release(); // also clears the size
+            data_ = data;
+            size_ = size;
+            capacity_ = capacity;
+        }
+
+        // grow or shrink.  new bytes are value initialized (as per std::vector)
+        void resize
+        (
+            std::size_t size
+        )
+        {
+            auto previousSize = size_;
+            resize_uninitialized(size);
+            if (size > previousSize)
+                std::memset(data_ + previousSize, 0, size - previousSize);
+        }
+
+        // grow or shrink.  new bytes are left uninitialized
+        void resize_uninitialized
+        (
+            std::size_t size
+        )
+        {
+            if (size > capacity_)
+                reserve(std::max(size, capacity_ * 2));
+            size_ = size;
+        }
+
+    private:
+
+        void release()
+        {
+            if (data_ != nullptr)
+                packet_arena::this_thread().deallocate(data_, capacity_);
+            data_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        }
+
+        char *          data_{nullptr};
+
+        std::size_t     size_{0};
+
+        std::size_t     capacity_{0};
+
+    }; // class aligned_packet
+
+    static_assert(packet_concept<aligned_packet>);
+
+} // namespace bcpp::message
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "./packet.h"
+#include "./shared_packet.h"
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // zero copy fan out of a transmitter's packets to any number of sinks.  the transmitter serializes each
+    // message once (into a packet from the broadcaster's shared_packet_pool) and every flushed packet is
+    // sealed into a single shared_packet which is handed to each connected sink.  the buffer returns to the
+    // pool when the last sink releases it (typically when the last receiver discards it).
+    //
+    // each sink's outstanding packets (delivered but not yet released) are tracked.  a sink which reaches
+    // maxOutstandingPackets_ is a slow consumer and, according to the policy, either misses packets until it
+    // catches up (drop) or is removed (disconnect).  either way the other sinks are never stalled.  packets
+    // from a transmitter only ever hold whole messages so a dropped packet never corrupts the stream.  when a
+    // sink pushes into a bounded packet queue keep maxOutstandingPackets_ within the queue's capacity so that
+    // the push never applies back pressure.
+    //
+    // publish(), add_sink() and remove_sink() are called by the transmitting thread.  packets may be released
+    // by any thread.  the broadcaster must outlive every packet that it has published.
+    template <packet_concept T>
+    class broadcaster :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+        using shared_packet_type = shared_packet<T>;
+        using sink_id = std::size_t;
+
+        static auto constexpr default_max_outstanding_packets = (1 << 8);
+
+        enum class slow_consumer_policy : std::uint8_t
+        {
+            drop,           // skip the sink until its outstanding packets fall below the limit
+            disconnect      // remove the sink
+        };
+
+        struct configuration
+        {
+            std::size_t                                     maxOutstandingPackets_ = default_max_outstanding_packets;
+            slow_consumer_policy                            slowConsumerPolicy_ = slow_consumer_policy::drop;
+            typename shared_packet_pool<T>::configuration   packetPoolConfiguration_{};
+        };
+
+        using sink_handler = std::function<void(shared_packet_type &&)>;
+
+        // called when a sink starts to miss packets (drop) or is removed (disconnect)
+        using slow_consumer_handler = std::function<void(sink_id, slow_consumer_policy)>;
+
+        struct event_handlers
+        {
+            slow_consumer_handler   slowConsumerHandler_;
+        };
+
+        struct sink_statistics
+        {
+            std::size_t delivered_{0};
+            std::size_t dropped_{0};
+            std::size_t outstanding_{0};
+            bool        connected_{false};
+        };
+
+        broadcaster
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        sink_id add_sink
+        (
+            sink_handler
+        );
+
+        void remove_sink
+        (
+            sink_id
+        );
+
+        void publish
+        (
+            packet_type &&
+        );
+
+        std::size_t get_sink_count() const;
+
+        sink_statistics get_sink_statistics
+        (
+            sink_id
+        ) const;
+
+        typename shared_packet_pool<T>::statistics get_packet_pool_statistics() const;
+
+        // handler for transmitter::event_handlers::packetAllocateHandler_
+        auto get_packet_allocate_handler()
+        {
+            return packetPool_.get_packet_allocate_handler();
+        }
+
+        // handler for transmitter::event_handlers::packetHandler_
+        auto get_packet_handler()
+        {
+            return [this](auto const &, packet_type packet){publish(std::move(packet));};
+        }
+
+    private:
+
+        struct sink
+        {
+            sink_handler                sinkHandler_;
+            std::atomic<std::size_t>    outstanding_{0};    // decremented by whichever thread releases the packet
+            std::size_t                 delivered_{0};
+            std::size_t                 dropped_{0};
+            bool                        connected_{true};
+            bool                        lagging_{false};
+        };
+
+        void on_slow_consumer
+        (
+            sink_id,
+            sink &
+        );
+
+        std::size_t                         maxOutstandingPackets_;
+
+        slow_consumer_policy                slowConsumerPolicy_;
+
+        slow_consumer_handler               slowConsumerHandler_;
+
+        shared_packet_pool<T>               packetPool_;
+
+        // sinks are never destroyed (nor their ids reused) while the broadcaster exists because packets
+        // which were delivered to a removed sink still refer to its outstanding counter
+        std::vector<std::unique_ptr<sink>>  sinks_;
+
+        std::size_t                         sinkCount_{0};
+
+    }; // class broadcaster
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::broadcaster<T>::broadcaster
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    maxOutstandingPackets_(std::max<std::size_t>(config.maxOutstandingPackets_, 1)),
+    slowConsumerPolicy_(config.slowConsumerPolicy_),
+    slowConsumerHandler_(std::move(eventHandlers.slowConsumerHandler_)),
+    packetPool_(config.packetPoolConfiguration_)
+{
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::broadcaster<T>::add_sink
+(
+    sink_handler sinkHandler
+) -> sink_id
+{
+    sinks_.push_back(std::make_unique<sink>());
+    sinks_.back()->sinkHandler_ = std::move(sinkHandler);
+    ++sinkCount_;
+    return (sinks_.size() - 1);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::broadcaster<T>::remove_sink
+(
+    sink_id sinkId
+)
+{
+    if ((sinkId < sinks_.size()) && (sinks_[sinkId]->connected_))
+    {
+        sinks_[sinkId]->connected_ = false;
+        sinks_[sinkId]->sinkHandler_ = nullptr;
+        --sinkCount_;
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::broadcaster<T>::publish
+(
+    packet_type && packet
+)
+{
+    auto sharedPacket = packetPool_.make_shared(std::move(packet));
+    for (sink_id sinkId = 0; sinkId < sinks_.size(); ++sinkId)
+    {
+        auto & s = *sinks_[sinkId];
+        if (!s.connected_)
+            continue;
+        if (s.outstanding_.load(std::memory_order_acquire) >= maxOutstandingPackets_)
+        {
+            on_slow_consumer(sinkId, s);
+            continue;
+        }
+        s.lagging_ = false;
+        ++s.delivered_;
+        s.sinkHandler_(sharedPacket.share(s.outstanding_));
+    }
+    // the buffer returns to the pool here if there are no sinks
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::broadcaster<T>::on_slow_consumer
+(
+    sink_id sinkId,
+    sink & s
+)
+{
+    if (slowConsumerPolicy_ == slow_consumer_policy::disconnect)
+    {
+        remove_sink(sinkId);
+    }
+    else
+    {
+        ++s.dropped_;
+        if (std::exchange(s.lagging_, true))
+            return; // only report the first packet dropped in each run
+    }
+    if (slowConsumerHandler_)
+        slowConsumerHandler_(sinkId, slowConsumerPolicy_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::broadcaster<T>::get_sink_count
+(
+) const
+{
+    return sinkCount_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::broadcaster<T>::get_sink_statistics
+(
+    sink_id sinkId
+) const -> sink_statistics
+{
+    if (sinkId >= sinks_.size())
+        return {};
+    auto const & s = *sinks_[sinkId];
+    return {s.delivered_, s.dropped_, s.outstanding_.load(std::memory_order_acquire), s.connected_};
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::broadcaster<T>::get_packet_pool_statistics
+(
+) const -> typename shared_packet_pool<T>::statistics
+{
+    return packetPool_.get_statistics();
+}
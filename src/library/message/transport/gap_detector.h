@@ -0,0 +1,383 @@
+#pragma once
+
+#include "./packet.h"
+#include "./sequencer.h"
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // receiving side of the sequencer's framing layer.  packets arriving from an unreliable transport are
+    // pushed into the gap detector which delivers them, strictly in sequence, to the packet handler (which
+    // typically pushes them into a receiver configured with packetHeadroom_ = sizeof(sequence_header)).
+    // the receiver therefore never sees a gap and never parses a fragment of a message as a header.
+    //
+    // packets which arrive ahead of a gap are held in a bounded reorder buffer and the missing range is
+    // requested via the replay request handler (typically forwarded to sequencer::retransmit()).  ranges
+    // which remain missing are requested again by poll() once the replay timeout expires.  packets too far
+    // ahead to be held are discarded (and recovered by replay) so memory never exceeds the reorder capacity.
+    // duplicates are discarded.  loss of the final packets of a stream is only detected once a later packet
+    // arrives or the sender's latest sequence is reported via notify_sequence() (from a heartbeat, say).
+    // not thread safe.
+    template <packet_concept T>
+    class gap_detector :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+        using clock = std::chrono::steady_clock;
+
+        static auto constexpr default_reorder_capacity = (1 << 10);
+        static auto constexpr default_replay_timeout = std::chrono::microseconds(100);
+
+        struct configuration
+        {
+            std::size_t                 reorderCapacity_ = default_reorder_capacity;    // packets held out of order
+            std::chrono::nanoseconds    replayTimeout_ = default_replay_timeout;        // before a gap is requested again
+        };
+
+        using packet_handler = std::function<void(packet_type &&)>;
+        using replay_request_handler = std::function<void(std::uint64_t first, std::size_t count)>;
+        using packet_discard_handler = std::function<void(packet_type &&)>;
+
+        struct event_handlers
+        {
+            packet_handler          packetHandler_;
+            replay_request_handler  replayRequestHandler_;
+            packet_discard_handler  packetDiscardHandler_;
+        };
+
+        struct statistics
+        {
+            std::size_t delivered_{0};
+            std::size_t reordered_{0};          // delivered from the reorder buffer
+            std::size_t duplicates_{0};
+            std::size_t overflows_{0};          // discarded because they were too far ahead to be held
+            std::size_t replayRequests_{0};
+            std::size_t maxBuffered_{0};        // high water mark of the reorder buffer
+        };
+
+        gap_detector
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        ~gap_detector();
+
+        void push
+        (
+            packet_type &&
+        );
+
+        // request any gap which has not been filled within the replay timeout.  returns true if a request was made.
+        bool poll
+        (
+            clock::time_point = clock::now()
+        );
+
+        // the sender has sent (at least) every packet up to and including this sequence
+        void notify_sequence
+        (
+            std::uint64_t
+        );
+
+        // the sequence number of the next packet to be delivered
+        std::uint64_t get_expected_sequence() const;
+
+        bool has_gap() const;
+
+        statistics get_statistics() const;
+
+    private:
+
+        static std::uint64_t get_sequence
+        (
+            packet_type const &
+        );
+
+        void deliver
+        (
+            packet_type &&
+        );
+
+        bool request_replay
+        (
+            std::uint64_t,
+            std::uint64_t,
+            clock::time_point
+        );
+
+        void discard
+        (
+            packet_type &&
+        );
+
+        std::size_t                 mask_;
+
+        std::vector<packet_type>    reorderBuffer_;
+
+        std::vector<std::uint64_t>  reorderSequence_;   // sequence held by each slot (zero when empty)
+
+        std::size_t                 buffered_{0};
+
+        std::uint64_t               expectedSequence_{1};
+
+        std::uint64_t               highestSequence_{0};    // highest sequence seen
+
+        std::uint64_t               requestedThrough_{0};   // every sequence below this has been requested
+
+        clock::time_point           lastRequestTime_;
+
+        std::chrono::nanoseconds    replayTimeout_;
+
+        packet_handler              packetHandler_;
+
+        replay_request_handler      replayRequestHandler_;
+
+        packet_discard_handler      packetDiscardHandler_;
+
+        statistics                  statistics_;
+
+    }; // class gap_detector
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::gap_detector<T>::gap_detector
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    mask_(std::bit_ceil(std::max<std::size_t>(config.reorderCapacity_, 1)) - 1),
+    reorderBuffer_(mask_ + 1),
+    reorderSequence_(mask_ + 1, 0),
+    replayTimeout_(config.replayTimeout_),
+    packetHandler_(std::move(eventHandlers.packetHandler_)),
+    replayRequestHandler_(std::move(eventHandlers.replayRequestHandler_)),
+    packetDiscardHandler_(std::move(eventHandlers.packetDiscardHandler_))
+{
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::gap_detector<T>::~gap_detector
+(
+)
+{
+    for (std::size_t i = 0; i < reorderBuffer_.size(); ++i)
+        if (reorderSequence_[i] != 0)
+            discard(std::move(reorderBuffer_[i]));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::uint64_t bcpp::message::gap_detector<T>::get_sequence
+(
+    packet_type const & packet
+)
+{
+    sequence_header sequenceHeader;
+    std::memcpy(&sequenceHeader, packet.data(), sizeof(sequenceHeader));
+    return sequenceHeader.sequence_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::gap_detector<T>::push
+(
+    packet_type && packet
+)
+{
+    if (packet.size() < sizeof(sequence_header))
+    {
+        discard(std::move(packet)); // not a framed packet
+        return;
+    }
+
+    auto sequence = get_sequence(packet);
+    if (sequence == expectedSequence_)
+    {
+        // in sequence (the common case).  deliver it along with any packets held behind it.
+        deliver(std::move(packet));
+        while (buffered_ > 0)
+        {
+            auto slot = (expectedSequence_ & mask_);
+            if (reorderSequence_[slot] != expectedSequence_)
+                break;
+            reorderSequence_[slot] = 0;
+            --buffered_;
+            ++statistics_.reordered_;
+            deliver(std::move(reorderBuffer_[slot]));
+        }
+        return;
+    }
+
+    if (sequence < expectedSequence_)
+    {
+        ++statistics_.duplicates_;
+        discard(std::move(packet));
+        return;
+    }
+
+    // a gap precedes this packet.  request the part of the gap which has not yet been requested but
+    // never beyond the reorder window (the replayed packets could not be held).
+    highestSequence_ = std::max(highestSequence_, sequence);
+    auto windowEnd = (expectedSequence_ + reorderBuffer_.size());
+    if (auto requestEnd = std::min(sequence, windowEnd); requestedThrough_ < requestEnd)
+    {
+        request_replay(std::max(requestedThrough_, expectedSequence_), requestEnd, clock::now());
+        requestedThrough_ = requestEnd;
+    }
+    if (sequence >= windowEnd)
+    {
+        // too far ahead to hold.  it is requested again once the window moves past the gap.
+        ++statistics_.overflows_;
+        discard(std::move(packet));
+        return;
+    }
+    requestedThrough_ = std::max(requestedThrough_, sequence + 1);
+    auto slot = (sequence & mask_);
+    if (reorderSequence_[slot] == sequence)
+    {
+        ++statistics_.duplicates_;
+        discard(std::move(packet));
+        return;
+    }
+    reorderSequence_[slot] = sequence;
+    reorderBuffer_[slot] = std::move(packet);
+    statistics_.maxBuffered_ = std::max(statistics_.maxBuffered_, ++buffered_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::gap_detector<T>::poll
+(
+    clock::time_point now
+)
+{
+    if ((!has_gap()) || ((now - lastRequestTime_) < replayTimeout_))
+        return false;
+    // request everything which is still missing up to the highest sequence seen (within the reorder window)
+    auto requestEnd = std::min(highestSequence_ + 1, expectedSequence_ + reorderBuffer_.size());
+    requestedThrough_ = std::max(requestedThrough_, requestEnd);
+    return request_replay(expectedSequence_, requestEnd, now);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::gap_detector<T>::notify_sequence
+(
+    std::uint64_t sequence
+)
+{
+    highestSequence_ = std::max(highestSequence_, sequence);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::gap_detector<T>::request_replay
+(
+    std::uint64_t first,
+    std::uint64_t last,
+    clock::time_point now
+)
+{
+    // request each run of missing packets (skipping those which are already held)
+    bool requested = false;
+    while (first < last)
+    {
+        while ((first < last) && (reorderSequence_[first & mask_] == first))
+            ++first;
+        auto end = first;
+        while ((end < last) && (reorderSequence_[end & mask_] != end))
+            ++end;
+        if (end == first)
+            break;
+        ++statistics_.replayRequests_;
+        if (replayRequestHandler_)
+            replayRequestHandler_(first, end - first);
+        requested = true;
+        first = end;
+    }
+    if (requested)
+        lastRequestTime_ = now;
+    return requested;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::gap_detector<T>::deliver
+(
+    packet_type && packet
+)
+{
+    ++expectedSequence_;
+    ++statistics_.delivered_;
+    packetHandler_(std::move(packet));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::gap_detector<T>::discard
+(
+    packet_type && packet
+)
+{
+    if (packetDiscardHandler_)
+        packetDiscardHandler_(std::move(packet));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::uint64_t bcpp::message::gap_detector<T>::get_expected_sequence
+(
+) const
+{
+    return expectedSequence_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::gap_detector<T>::has_gap
+(
+) const
+{
+    return (buffered_ > 0) || (highestSequence_ >= expectedSequence_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::gap_detector<T>::get_statistics
+(
+) const -> statistics
+{
+    return statistics_;
+}
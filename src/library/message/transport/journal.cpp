@@ -0,0 +1,325 @@
+#include "./journal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace
+{
+
+    //=========================================================================
+    std::size_t align_record
+    (
+        std::size_t size
+    )
+    {
+        using journal_format = bcpp::message::journal_format;
+        return ((size + journal_format::record_alignment - 1) & ~std::size_t(journal_format::record_alignment - 1));
+    }
+
+} // namespace
+
+
+//=============================================================================
+std::string bcpp::message::journal_format::get_segment_path
+(
+    std::string const & directory,
+    std::string const & name,
+    std::size_t index
+)
+{
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06zu.journal", index);
+    return directory + "/" + name + suffix;
+}
+
+
+//=============================================================================
+bcpp::message::journal_writer::journal_writer
+(
+    configuration const & config
+):
+    config_(config)
+{
+    config_.segmentSize_ = align_record(std::max<std::size_t>(config_.segmentSize_, (1 << 16)));
+    open_segment(0);
+}
+
+
+//=============================================================================
+bcpp::message::journal_writer::~journal_writer
+(
+)
+{
+    close();
+}
+
+
+//=============================================================================
+std::uint64_t bcpp::message::journal_writer::now
+(
+)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_writer::is_valid
+(
+) const
+{
+    return (segment_ != nullptr);
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_writer::open_segment
+(
+    std::size_t minimumSize
+)
+{
+    // segments are sparse files so the unused tail of a segment costs nothing until it is written
+    segmentSize_ = std::max(config_.segmentSize_, align_record(sizeof(journal_format::segment_header) + minimumSize + 
+            (sizeof(journal_format::record_header) * 2)));
+    auto path = journal_format::get_segment_path(config_.directory_, config_.name_, segmentIndex_);
+    if (fd_ = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644); fd_ == -1)
+        return false;
+    if (::ftruncate(fd_, segmentSize_) != 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    auto mapping = ::mmap(nullptr, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    segment_ = reinterpret_cast<char *>(mapping);
+    journal_format::segment_header segmentHeader{journal_format::magic, journal_format::version, static_cast<std::uint32_t>(segmentIndex_)};
+    std::memcpy(segment_, &segmentHeader, sizeof(segmentHeader));
+    offset_ = align_record(sizeof(segmentHeader));
+    return true;
+}
+
+
+//=============================================================================
+void bcpp::message::journal_writer::close_segment
+(
+)
+{
+    if (segment_ != nullptr)
+    {
+        ::munmap(segment_, segmentSize_);
+        segment_ = nullptr;
+    }
+    if (fd_ != -1)
+    {
+        // the zeroed record header which follows the last record marks the end of the journal
+        static_cast<void>(::ftruncate(fd_, offset_ + sizeof(journal_format::record_header)));
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_writer::append
+(
+    std::span<char const> packet,
+    std::uint64_t timestamp
+)
+{
+    if ((!is_valid()) || (packet.empty()) || (packet.size() >= journal_format::end_of_segment))
+        return false;
+
+    auto recordSize = align_record(sizeof(journal_format::record_header) + packet.size());
+    // always leave room for the record header which marks the end of the segment
+    if ((offset_ + recordSize + sizeof(journal_format::record_header)) > segmentSize_)
+    {
+        journal_format::record_header endOfSegment{0, journal_format::end_of_segment, 0};
+        std::memcpy(segment_ + offset_, &endOfSegment, sizeof(endOfSegment));
+        offset_ += sizeof(endOfSegment);
+        close_segment();
+        ++segmentIndex_;
+        if (!open_segment(packet.size()))
+            return false;
+    }
+
+    journal_format::record_header recordHeader{timestamp, static_cast<std::uint32_t>(packet.size()), 0};
+    std::memcpy(segment_ + offset_, &recordHeader, sizeof(recordHeader));
+    std::memcpy(segment_ + offset_ + sizeof(recordHeader), packet.data(), packet.size());
+    offset_ += recordSize;
+    ++packetsWritten_;
+    bytesWritten_ += packet.size();
+    return true;
+}
+
+
+//=============================================================================
+void bcpp::message::journal_writer::close
+(
+)
+{
+    close_segment();
+}
+
+
+//=============================================================================
+std::size_t bcpp::message::journal_writer::get_packets_written
+(
+) const
+{
+    return packetsWritten_;
+}
+
+
+//=============================================================================
+std::size_t bcpp::message::journal_writer::get_bytes_written
+(
+) const
+{
+    return bytesWritten_;
+}
+
+
+//=============================================================================
+bcpp::message::journal_reader::journal_reader
+(
+    configuration const & config
+):
+    config_(config)
+{
+    open_segment(0);
+}
+
+
+//=============================================================================
+bcpp::message::journal_reader::~journal_reader
+(
+)
+{
+    close_segment();
+    release_retired_segments();
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_reader::is_valid
+(
+) const
+{
+    return (segment_ != nullptr);
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_reader::open_segment
+(
+    std::size_t index
+)
+{
+    auto path = journal_format::get_segment_path(config_.directory_, config_.name_, index);
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat status;
+    if ((::fstat(fd, &status) != 0) || (static_cast<std::size_t>(status.st_size) < sizeof(journal_format::segment_header)))
+    {
+        ::close(fd);
+        return false;
+    }
+    auto mapping = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    ::madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+
+    journal_format::segment_header segmentHeader;
+    std::memcpy(&segmentHeader, mapping, sizeof(segmentHeader));
+    if ((segmentHeader.magic_ != journal_format::magic) || (segmentHeader.version_ != journal_format::version) || (segmentHeader.index_ != index))
+    {
+        ::munmap(mapping, status.st_size);
+        return false;
+    }
+    segment_ = reinterpret_cast<char const *>(mapping);
+    segmentSize_ = status.st_size;
+    segmentIndex_ = index;
+    offset_ = align_record(sizeof(segmentHeader));
+    return true;
+}
+
+
+//=============================================================================
+void bcpp::message::journal_reader::close_segment
+(
+)
+{
+    if (segment_ != nullptr)
+        ::munmap(const_cast<char *>(segment_), segmentSize_);
+    segment_ = nullptr;
+}
+
+
+//=============================================================================
+bool bcpp::message::journal_reader::next
+(
+    record & r
+)
+{
+    while (segment_ != nullptr)
+    {
+        if ((offset_ + sizeof(journal_format::record_header)) > segmentSize_)
+            return false; // truncated segment
+        journal_format::record_header recordHeader;
+        std::memcpy(&recordHeader, segment_ + offset_, sizeof(recordHeader));
+        if (recordHeader.size_ == 0)
+            return false; // end of journal
+        if (recordHeader.size_ == journal_format::end_of_segment)
+        {
+            // views of this segment may still be in use (see release_retired_segments)
+            retiredSegments_.emplace_back(segment_, segmentSize_);
+            segment_ = nullptr;
+            if (!open_segment(segmentIndex_ + 1))
+                return false;
+            continue;
+        }
+        if ((offset_ + sizeof(recordHeader) + recordHeader.size_) > segmentSize_)
+            return false; // truncated record
+        // receivers never write to their packets so the read only mapping can be viewed as a packet
+        r.timestamp_ = recordHeader.timestamp_;
+        r.packet_ = packet_view(const_cast<char *>(segment_ + offset_ + sizeof(recordHeader)), recordHeader.size_, recordHeader.size_);
+        offset_ += align_record(sizeof(recordHeader) + recordHeader.size_);
+        return true;
+    }
+    return false;
+}
+
+
+//=============================================================================
+void bcpp::message::journal_reader::release_retired_segments
+(
+)
+{
+    for (auto [segment, segmentSize] : retiredSegments_)
+        ::munmap(const_cast<char *>(segment), segmentSize);
+    retiredSegments_.clear();
+}
+
+
+//=============================================================================
+std::size_t bcpp::message::journal_reader::get_segment_index
+(
+) const
+{
+    return segmentIndex_;
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "./packet_view.h"
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // on disk format shared by journal_writer and journal_reader.  a journal is a sequence of segment 
+    // files named <directory>/<name>.<index>.journal.  each segment begins with a segment_header which is
+    // followed by records.  each record is a record_header followed by the packet's bytes, padded to 
+    // record_alignment.  a record size of zero marks the end of the journal and a record size of 
+    // end_of_segment marks the end of the segment (the journal continues in the next segment).
+    struct journal_format
+    {
+        static auto constexpr magic = std::uint64_t(0x62637070'6a726e6c); // "bcppjrnl"
+        static auto constexpr version = std::uint32_t(1);
+        static auto constexpr record_alignment = 8;
+        static auto constexpr end_of_segment = std::uint32_t(0xffffffff);
+
+        struct segment_header
+        {
+            std::uint64_t   magic_;
+            std::uint32_t   version_;
+            std::uint32_t   index_;
+        };
+
+        struct record_header
+        {
+            std::uint64_t   timestamp_; // steady clock nanoseconds at which the packet was captured
+            std::uint32_t   size_;
+            std::uint32_t   reserved_;
+        };
+
+        static std::string get_segment_path
+        (
+            std::string const & directory,
+            std::string const & name,
+            std::size_t index
+        );
+    };
+
+
+    //=========================================================================
+    // appends packets, with timestamps, to a segmented memory mapped journal.  not thread safe.
+    class journal_writer :
+        non_copyable
+    {
+    public:
+
+        static auto constexpr default_segment_size = (1 << 26);
+
+        struct configuration
+        {
+            std::string     directory_{"."};
+            std::string     name_{"journal"};
+            std::size_t     segmentSize_{default_segment_size};
+        };
+
+        journal_writer
+        (
+            configuration const &
+        );
+
+        ~journal_writer();
+
+        bool is_valid() const;
+
+        bool append
+        (
+            std::span<char const>,
+            std::uint64_t timestamp = now()
+        );
+
+        // truncate the current segment to the bytes written and release it
+        void close();
+
+        std::size_t get_packets_written() const;
+
+        std::size_t get_bytes_written() const;
+
+        // handler for receiver::event_handlers::packetCaptureHandler_
+        auto get_packet_capture_handler()
+        {
+            return [this](auto const &, auto const & packet){append(std::span<char const>(packet.data(), packet.size()));};
+        }
+
+        // wrap a transmitter packet handler so that flushed packets are captured before being handed on
+        template <typename H>
+        auto get_packet_handler
+        (
+            H packetHandler
+        )
+        {
+            return [this, packetHandler = std::move(packetHandler)](auto const & transmitter, auto packet) mutable
+                    {
+                        append(std::span<char const>(packet.data(), packet.size()));
+                        packetHandler(transmitter, std::move(packet));
+                    };
+        }
+
+        static std::uint64_t now();
+
+    private:
+
+        bool open_segment
+        (
+            std::size_t
+        );
+
+        void close_segment();
+
+        configuration           config_;
+
+        std::size_t             segmentIndex_{0};
+
+        int                     fd_{-1};
+
+        char *                  segment_{nullptr};
+
+        std::size_t             segmentSize_{0};
+
+        std::size_t             offset_{0};
+
+        std::size_t             packetsWritten_{0};
+
+        std::size_t             bytesWritten_{0};
+
+    }; // class journal_writer
+
+
+    //=========================================================================
+    // maps the segments of a journal and yields its packets as views of the mapping.  a record is a 
+    // packet as captured so a message can straddle records (and therefore segments).  segments which have
+    // been read past are retired rather than unmapped so that views of them remain valid until the caller
+    // releases them.
+    class journal_reader :
+        non_copyable
+    {
+    public:
+
+        struct configuration
+        {
+            std::string     directory_{"."};
+            std::string     name_{"journal"};
+        };
+
+        struct record
+        {
+            std::uint64_t   timestamp_;
+            packet_view     packet_;
+        };
+
+        enum class replay_mode
+        {
+            as_fast_as_possible,
+            paced               // reproduce the original spacing of the packets (scaled by speed_ which must be positive
+                                // or the journal is replayed as fast as possible)
+        };
+
+        struct replay_configuration
+        {
+            replay_mode     mode_{replay_mode::as_fast_as_possible};
+            double          speed_{1.0};
+        };
+
+        struct replay_statistics
+        {
+            std::size_t                 packets_{0};
+            std::size_t                 bytes_{0};
+            std::size_t                 messages_{0};
+            std::chrono::nanoseconds    elapsed_{0};
+
+            double messages_per_second() const
+            {
+                return (elapsed_.count() == 0) ? 0.0 : ((messages_ * 1'000'000'000.0) / elapsed_.count());
+            }
+
+            double bytes_per_second() const
+            {
+                return (elapsed_.count() == 0) ? 0.0 : ((bytes_ * 1'000'000'000.0) / elapsed_.count());
+            }
+        };
+
+        journal_reader
+        (
+            configuration const &
+        );
+
+        ~journal_reader();
+
+        bool is_valid() const;
+
+        // the next record.  returns false at the end of the journal.  the view remains valid until 
+        // release_retired_segments() is called after the reader has moved on to a later segment (or until
+        // the reader is destroyed).
+        bool next
+        (
+            record &
+        );
+
+        std::size_t get_segment_index() const;
+
+        // unmap every segment before the current one.  call only once no view of those segments remains in
+        // use (such as once a receiver holding views is empty).
+        void release_retired_segments();
+
+        // feed every packet of the journal into a receiver whose packets are packet_views.  the receiver
+        // is drained after each packet.  a message which straddles records leaves views queued in the
+        // receiver so earlier segments are only released once the receiver is empty.
+        template <typename R>
+        replay_statistics replay
+        (
+            R &,
+            replay_configuration const & = {}
+        );
+
+    private:
+
+        bool open_segment
+        (
+            std::size_t
+        );
+
+        void close_segment();
+
+        configuration           config_;
+
+        std::size_t             segmentIndex_{0};
+
+        char const *            segment_{nullptr};
+
+        std::size_t             segmentSize_{0};
+
+        std::size_t             offset_{0};
+
+        // mappings (address and size) of segments which have been read past
+        std::vector<std::pair<char const *, std::size_t>> retiredSegments_;
+
+    }; // class journal_reader
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <typename R>
+auto bcpp::message::journal_reader::replay
+(
+    R & receiver,
+    replay_configuration const & replayConfiguration
+) -> replay_statistics
+{
+    replay_statistics statistics;
+    record r;
+    std::uint64_t firstTimestamp = 0;
+    // a speed which is not positive (or is not a number) can not scale the spacing
+    bool paced = ((replayConfiguration.mode_ == replay_mode::paced) && (replayConfiguration.speed_ > 0.0));
+    auto start = std::chrono::steady_clock::now();
+    while (next(r))
+    {
+        if (paced)
+        {
+            if (statistics.packets_ == 0)
+                firstTimestamp = r.timestamp_;
+            // clamped as a tiny speed can scale the delay beyond the range of the clock
+            auto delay = std::min((r.timestamp_ - firstTimestamp) / replayConfiguration.speed_, static_cast<double>(std::numeric_limits<std::int32_t>::max()) * 1'000'000'000.0);
+            auto due = start + std::chrono::nanoseconds(static_cast<std::int64_t>(delay));
+            while (std::chrono::steady_clock::now() < due)
+                std::this_thread::yield();
+        }
+        ++statistics.packets_;
+        statistics.bytes_ += r.packet_.size();
+        receiver << std::move(r.packet_);
+        statistics.messages_ += receiver.process_all();
+        if ((!retiredSegments_.empty()) && (receiver.empty()))
+            release_retired_segments();
+    }
+    statistics.elapsed_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return statistics;
+}
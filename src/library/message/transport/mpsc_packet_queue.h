@@ -0,0 +1,302 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // bounded lock free multiple producer single consumer packet queue.  satisfies packet_queue_concept.
+    // producers claim slots with a CAS on the push index and publish each slot via its sequence number.
+    // front(), pop() and empty() are called by the (single) consumer thread only.
+    template <packet_concept T>
+    class mpsc_packet_queue :
+        non_copyable
+    {
+    public:
+
+        using value_type = T;
+
+        static auto constexpr concurrent = true;
+        static auto constexpr default_capacity = (1 << 10);
+
+        explicit mpsc_packet_queue
+        (
+            std::size_t = default_capacity
+        );
+
+        // returns false (leaving the packet untouched) if the queue is full
+        bool push
+        (
+            value_type &&
+        );
+
+        bool push
+        (
+            value_type const &
+        );
+
+        // claim slots for as many of the packets as will fit with a single CAS.  the packets are pushed
+        // contiguously and in order.  returns the number of packets pushed (moved from).
+        std::size_t push
+        (
+            std::span<value_type>
+        );
+
+        value_type & front();
+
+        void pop();
+
+        // pop up to 'count' packets.  returns the number of packets popped.
+        std::size_t pop
+        (
+            std::size_t count
+        );
+
+        bool empty() const;
+
+        std::size_t size() const;
+
+        std::size_t capacity() const;
+
+    private:
+
+        static auto constexpr cache_line_size = 64;
+
+        struct alignas(cache_line_size) slot
+        {
+            std::atomic<std::size_t>    sequence_;
+            value_type                  packet_;
+        };
+
+        template <typename P>
+        bool emplace
+        (
+            P &&
+        );
+
+        std::size_t                                         capacity_;
+
+        std::size_t                                         mask_;
+
+        std::unique_ptr<slot []>                            slots_;
+
+        // producers' cache line
+        alignas(cache_line_size) std::atomic<std::size_t>   pushIndex_{0};
+
+        // consumer's cache line
+        alignas(cache_line_size) std::atomic<std::size_t>   popIndex_{0};
+
+    }; // class mpsc_packet_queue
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::mpsc_packet_queue<T>::mpsc_packet_queue
+(
+    std::size_t capacity
+):
+    capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+    mask_(capacity_ - 1),
+    slots_(std::make_unique<slot []>(capacity_))
+{
+    // a slot is free for the push at position N when its sequence is N and holds a packet for the
+    // pop at position N when its sequence is N + 1
+    for (std::size_t i = 0; i < capacity_; ++i)
+        slots_[i].sequence_.store(i, std::memory_order_relaxed);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+template <typename P>
+bool bcpp::message::mpsc_packet_queue<T>::emplace
+(
+    P && packet
+)
+{
+    auto pushIndex = pushIndex_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto & s = slots_[pushIndex & mask_];
+        auto difference = static_cast<std::ptrdiff_t>(s.sequence_.load(std::memory_order_acquire) - pushIndex);
+        if (difference == 0)
+        {
+            if (pushIndex_.compare_exchange_weak(pushIndex, pushIndex + 1, std::memory_order_relaxed))
+            {
+                s.packet_ = std::forward<P>(packet);
+                s.sequence_.store(pushIndex + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false; // full
+        }
+        else
+        {
+            pushIndex = pushIndex_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::mpsc_packet_queue<T>::push
+(
+    value_type && packet
+)
+{
+    return emplace(std::move(packet));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::mpsc_packet_queue<T>::push
+(
+    value_type const & packet
+)
+{
+    return emplace(packet);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::mpsc_packet_queue<T>::push
+(
+    std::span<value_type> packets
+)
+{
+    if (packets.empty())
+        return 0;
+    auto isFree = [&](std::size_t index){return (slots_[index & mask_].sequence_.load(std::memory_order_acquire) == index);};
+    auto pushIndex = pushIndex_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto difference = static_cast<std::ptrdiff_t>(slots_[pushIndex & mask_].sequence_.load(std::memory_order_acquire) - pushIndex);
+        if (difference < 0)
+            return 0; // full
+        if (difference > 0)
+        {
+            // another producer has claimed pushIndex
+            pushIndex = pushIndex_.load(std::memory_order_relaxed);
+            continue;
+        }
+        // slots are released by the consumer in order so the free slots following pushIndex form a
+        // contiguous run.  binary search for the end of that run.
+        std::size_t count = 1;
+        std::size_t high = std::min(packets.size(), capacity_);
+        while (count < high)
+        {
+            auto mid = ((count + high + 1) / 2);
+            if (isFree(pushIndex + mid - 1))
+                count = mid;
+            else
+                high = mid - 1;
+        }
+        if (pushIndex_.compare_exchange_weak(pushIndex, pushIndex + count, std::memory_order_relaxed))
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto & s = slots_[(pushIndex + i) & mask_];
+                s.packet_ = std::move(packets[i]);
+                s.sequence_.store(pushIndex + i + 1, std::memory_order_release);
+            }
+            return count;
+        }
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::mpsc_packet_queue<T>::front
+(
+) -> value_type &
+{
+    return slots_[popIndex_.load(std::memory_order_relaxed) & mask_].packet_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::mpsc_packet_queue<T>::pop
+(
+)
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    auto & s = slots_[popIndex & mask_];
+    s.packet_ = value_type(); // release whatever the packet still holds
+    s.sequence_.store(popIndex + capacity_, std::memory_order_release);
+    popIndex_.store(popIndex + 1, std::memory_order_relaxed);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::mpsc_packet_queue<T>::pop
+(
+    std::size_t count
+)
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    std::size_t popped = 0;
+    for (; popped < count; ++popped)
+    {
+        auto & s = slots_[(popIndex + popped) & mask_];
+        if (s.sequence_.load(std::memory_order_acquire) != (popIndex + popped + 1))
+            break; // not yet published
+        s.packet_ = value_type();
+        s.sequence_.store(popIndex + popped + capacity_, std::memory_order_release);
+    }
+    popIndex_.store(popIndex + popped, std::memory_order_relaxed);
+    return popped;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::mpsc_packet_queue<T>::empty
+(
+) const
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    return (slots_[popIndex & mask_].sequence_.load(std::memory_order_acquire) != (popIndex + 1));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::mpsc_packet_queue<T>::size
+(
+) const
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    auto pushIndex = pushIndex_.load(std::memory_order_relaxed);
+    return (pushIndex > popIndex) ? (pushIndex - popIndex) : 0;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::mpsc_packet_queue<T>::capacity
+(
+) const
+{
+    return capacity_;
+}
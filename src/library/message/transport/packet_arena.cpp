@@ -0,0 +1,256 @@
+#include "./packet_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <new>
+
+
+namespace
+{
+
+    std::mutex mutex;
+
+    bcpp::message::packet_arena::configuration defaultConfiguration;
+
+} // namespace
+
+
+//=============================================================================
+bcpp::message::packet_arena::thread_exit_handler::~thread_exit_handler
+(
+)
+{
+    arena_->orphan();
+}
+
+
+//=============================================================================
+auto bcpp::message::packet_arena::this_thread
+(
+) -> packet_arena &
+{
+    // the arena itself is heap allocated as it outlives the thread until its last block is freed
+    static thread_local thread_exit_handler threadExitHandler{new packet_arena([]()
+            {
+                std::lock_guard lockGuard(mutex);
+                return defaultConfiguration;
+            }())};
+    return *threadExitHandler.arena_;
+}
+
+
+//=============================================================================
+void bcpp::message::packet_arena::set_default_configuration
+(
+    configuration const & config
+)
+{
+    std::lock_guard lockGuard(mutex);
+    defaultConfiguration = config;
+}
+
+
+//=============================================================================
+bcpp::message::packet_arena::packet_arena
+(
+    configuration const & config
+):
+    config_(config)
+{
+    config_.chunkSize_ = std::bit_ceil(std::max<std::size_t>(config_.chunkSize_, segment_size));
+}
+
+
+//=============================================================================
+bcpp::message::packet_arena::~packet_arena
+(
+)
+{
+    for (auto chunk : chunks_)
+        ::munmap(chunk, config_.chunkSize_);
+}
+
+
+//=============================================================================
+void bcpp::message::packet_arena::orphan
+(
+)
+{
+    // called by the owning thread as it exits.  blocks freed by other threads from here on count down
+    // orphanedBlocks_ rather than being pushed onto the remote free list.
+    auto remoteFrees = remoteFrees_.exchange(orphaned, std::memory_order_acquire);
+    for (; remoteFrees != nullptr; remoteFrees = remoteFrees->next_)
+        --liveBlocks_;
+    auto liveBlocks = static_cast<std::int64_t>(liveBlocks_);
+    if ((orphanedBlocks_.fetch_add(liveBlocks, std::memory_order_acq_rel) + liveBlocks) == 0)
+        delete this;
+}
+
+
+//=============================================================================
+std::size_t bcpp::message::packet_arena::get_size_class
+(
+    std::size_t capacity
+)
+{
+    static auto constexpr min_block_size_bits = std::bit_width(std::size_t(min_block_size)) - 1;
+    return (std::bit_width(std::max<std::size_t>(capacity, min_block_size) - 1) - min_block_size_bits);
+}
+
+
+//=============================================================================
+void * bcpp::message::packet_arena::allocate
+(
+    std::size_t & capacity
+)
+{
+    if (capacity > max_block_size)
+    {
+        // too large for the arena
+        capacity = ((capacity + alignment - 1) & ~std::size_t(alignment - 1));
+        return ::operator new(capacity, std::align_val_t(alignment));
+    }
+
+    auto sizeClass = get_size_class(capacity);
+    capacity = (std::size_t(min_block_size) << sizeClass);
+    if ((freeLists_[sizeClass] == nullptr) && (remoteFrees_.load(std::memory_order_relaxed) != nullptr))
+        drain_remote_frees();
+    ++liveBlocks_;
+    if (auto block = freeLists_[sizeClass]; block != nullptr)
+    {
+        freeLists_[sizeClass] = block->next_;
+        return block;
+    }
+    return allocate_from_chunk(capacity);
+}
+
+
+//=============================================================================
+void bcpp::message::packet_arena::deallocate
+(
+    void * address,
+    std::size_t capacity
+)
+{
+    if (address == nullptr)
+        return;
+    if (capacity > max_block_size)
+    {
+        ::operator delete(address, std::align_val_t(alignment));
+        return;
+    }
+    auto block = reinterpret_cast<free_block *>(address);
+    block->sizeClass_ = get_size_class(capacity);
+    auto owner = reinterpret_cast<segment_header *>(reinterpret_cast<std::uintptr_t>(address) & ~std::uintptr_t(segment_size - 1))->arena_;
+    if (owner != this)
+    {
+        owner->push_remote_free(block);
+        return;
+    }
+    block->next_ = freeLists_[block->sizeClass_];
+    freeLists_[block->sizeClass_] = block;
+    --liveBlocks_;
+}
+
+
+//=============================================================================
+void bcpp::message::packet_arena::push_remote_free
+(
+    free_block * block
+)
+{
+    // called by threads other than the owner
+    auto head = remoteFrees_.load(std::memory_order_relaxed);
+    do
+    {
+        if (head == orphaned)
+        {
+            // the owning thread has exited.  the last block freed releases the arena.
+            if (orphanedBlocks_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+            return;
+        }
+        block->next_ = head;
+    }
+    while (!remoteFrees_.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+//=============================================================================
+void bcpp::message::packet_arena::drain_remote_frees
+(
+)
+{
+    auto block = remoteFrees_.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr)
+    {
+        auto next = block->next_;
+        block->next_ = freeLists_[block->sizeClass_];
+        freeLists_[block->sizeClass_] = block;
+        --liveBlocks_;
+        block = next;
+    }
+}
+
+
+//=============================================================================
+void * bcpp::message::packet_arena::allocate_from_chunk
+(
+    std::size_t blockSize
+)
+{
+    // blocks never straddle a segment boundary so that the segment header of every block is found by
+    // masking its address
+    auto segmentEnd = reinterpret_cast<std::uint8_t *>((reinterpret_cast<std::uintptr_t>(chunkCurrent_) + segment_size - 1) & ~std::uintptr_t(segment_size - 1));
+    if ((chunkCurrent_ != nullptr) && (static_cast<std::size_t>(segmentEnd - chunkCurrent_) < blockSize))
+    {
+        // move on to the next segment of the chunk (any remainder is abandoned)
+        chunkCurrent_ = segmentEnd;
+        if (chunkCurrent_ < chunkEnd_)
+        {
+            reinterpret_cast<segment_header *>(chunkCurrent_)->arena_ = this;
+            chunkCurrent_ += sizeof(segment_header);
+        }
+    }
+    if (chunkCurrent_ >= chunkEnd_)
+    {
+        // current chunk is exhausted.  map a new, segment aligned, chunk.
+        void * chunk = MAP_FAILED;
+        if (config_.useHugePages_)
+        {
+            chunk = ::mmap(nullptr, config_.chunkSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if ((chunk != MAP_FAILED) && ((reinterpret_cast<std::uintptr_t>(chunk) & (segment_size - 1)) != 0))
+            {
+                ::munmap(chunk, config_.chunkSize_);
+                chunk = MAP_FAILED;
+            }
+        }
+        if (chunk == MAP_FAILED)
+        {
+            // over map and trim to align
+            auto mapping = ::mmap(nullptr, config_.chunkSize_ + segment_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED)
+                throw std::bad_alloc();
+            auto begin = reinterpret_cast<std::uintptr_t>(mapping);
+            auto aligned = ((begin + segment_size - 1) & ~std::uintptr_t(segment_size - 1));
+            if (aligned > begin)
+                ::munmap(mapping, aligned - begin);
+            ::munmap(reinterpret_cast<void *>(aligned + config_.chunkSize_), (begin + segment_size) - aligned);
+            chunk = reinterpret_cast<void *>(aligned);
+            if (config_.useHugePages_)
+                ::madvise(chunk, config_.chunkSize_, MADV_HUGEPAGE); // fall back to transparent huge pages
+        }
+        chunks_.push_back(chunk);
+        chunkCurrent_ = reinterpret_cast<std::uint8_t *>(chunk);
+        chunkEnd_ = chunkCurrent_ + config_.chunkSize_;
+        reinterpret_cast<segment_header *>(chunkCurrent_)->arena_ = this;
+        chunkCurrent_ += sizeof(segment_header);
+    }
+    // block sizes are multiples of the alignment and segments are aligned so every block is aligned
+    auto block = chunkCurrent_;
+    chunkCurrent_ += blockSize;
+    return block;
+}
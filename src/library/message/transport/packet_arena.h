@@ -0,0 +1,134 @@
+#pragma once
+
+#include <include/non_copyable.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // per-thread arena of 64 byte aligned packet storage.  blocks are power of two sized and are carved
+    // from large chunks mapped directly from the OS (optionally backed by huge pages).  every block belongs
+    // to the arena which carved it (found via the header at the start of each of its chunk's segments).
+    // blocks freed by the owning thread go straight onto its per size class free lists.  blocks freed by
+    // any other thread are pushed onto the owner's lock free remote free list, which the owner drains into
+    // its free lists when they run dry, so memory flows back to the allocating thread in producer/consumer
+    // pipelines.  when a thread exits its arena lives on until the last of its blocks is freed, at which
+    // point its chunks are returned to the OS.
+    class packet_arena :
+        non_copyable
+    {
+    public:
+
+        static auto constexpr alignment = 64;
+        static auto constexpr min_block_size = alignment;
+        static auto constexpr max_block_size = (1 << 20);
+        static auto constexpr default_chunk_size = (1 << 21); // size of a single (2MB) huge page
+        static auto constexpr segment_size = default_chunk_size; // chunks are segment aligned multiples of segments
+
+        struct configuration
+        {
+            bool        useHugePages_ = false;
+            std::size_t chunkSize_ = default_chunk_size;
+        };
+
+        // the arena for the calling thread
+        static packet_arena & this_thread();
+
+        // sets the configuration used by arenas created after this call
+        static void set_default_configuration
+        (
+            configuration const &
+        );
+
+        // returns storage for at least 'capacity' bytes and updates 'capacity' to the usable size
+        void * allocate
+        (
+            std::size_t & capacity
+        );
+
+        // the block may have been allocated by any thread's arena
+        void deallocate
+        (
+            void *,
+            std::size_t capacity
+        );
+
+    private:
+
+        struct free_block
+        {
+            free_block *    next_;
+            std::size_t     sizeClass_;
+        };
+
+        // at the start of every segment of every chunk
+        struct alignas(alignment) segment_header
+        {
+            packet_arena *  arena_;
+        };
+
+        struct thread_exit_handler
+        {
+            ~thread_exit_handler();
+            packet_arena * arena_;
+        };
+
+        static auto constexpr size_class_count = 15; // min_block_size .. max_block_size
+
+        // marks the remote free list of an arena whose thread has exited
+        static inline auto const orphaned = reinterpret_cast<free_block *>(alignment);
+
+        static std::size_t get_size_class
+        (
+            std::size_t
+        );
+
+        packet_arena
+        (
+            configuration const &
+        );
+
+        ~packet_arena();
+
+        void * allocate_from_chunk
+        (
+            std::size_t
+        );
+
+        void drain_remote_frees();
+
+        void push_remote_free
+        (
+            free_block *
+        );
+
+        void orphan();
+
+        configuration                                   config_;
+
+        std::array<free_block *, size_class_count>      freeLists_{};
+
+        std::uint8_t *                                  chunkCurrent_{nullptr};
+
+        std::uint8_t *                                  chunkEnd_{nullptr};
+
+        std::vector<void *>                             chunks_;
+
+        // blocks which have been allocated and not yet returned to this arena (owning thread only)
+        std::size_t                                     liveBlocks_{0};
+
+        alignas(alignment) std::atomic<free_block *>    remoteFrees_{nullptr};
+
+        // blocks outstanding once orphaned.  released when this reaches zero.
+        std::atomic<std::int64_t>                       orphanedBlocks_{0};
+
+    }; // class packet_arena
+
+} // namespace bcpp::message
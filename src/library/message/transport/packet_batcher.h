@@ -0,0 +1,234 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // accumulates flushed packets and externally owned payloads into an iovec batch which is delivered 
+    // in a single callback (ready for writev or sendmmsg).  the batch is delivered when it reaches either
+    // the entry or the byte limit, or when flush() is called (transmitter::flush() does so via the
+    // packet handler).  once delivered, packets are handed to the packet release handler (for instance 
+    // packet_pool::put) and attached payloads are no longer referenced.  not thread safe.
+    template <packet_concept T>
+    class packet_batcher :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+
+        static auto constexpr default_max_entries = 64; // well below IOV_MAX (1024)
+
+        struct configuration
+        {
+            std::size_t maxEntries_ = default_max_entries;
+            std::size_t maxBytes_ = 0; // zero for no limit
+        };
+
+        using batch_handler = std::function<void(std::span<iovec const>)>;
+        using packet_release_handler = std::function<void(packet_type &&)>;
+
+        struct event_handlers
+        {
+            batch_handler           batchHandler_;
+            packet_release_handler  packetReleaseHandler_;
+        };
+
+        // statically bound packet handler for transmitter::event_handlers::packetHandler_.  enables 
+        // transmitter::attach() and has transmitter::flush() deliver the batch.
+        class packet_handler
+        {
+        public:
+            packet_handler(packet_batcher & packetBatcher):packetBatcher_(&packetBatcher){}
+            void operator()(auto const &, packet_type packet){packetBatcher_->push(std::move(packet));}
+            void attach(std::span<char const> payload){packetBatcher_->attach(payload);}
+            void flush(){packetBatcher_->flush();}
+        private:
+            packet_batcher * packetBatcher_;
+        };
+
+        packet_batcher
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        // delivers any remaining batch
+        ~packet_batcher();
+
+        void push
+        (
+            packet_type &&
+        );
+
+        // the payload must remain valid until the batch which references it is delivered
+        void attach
+        (
+            std::span<char const>
+        );
+
+        void flush();
+
+        std::size_t size() const;
+
+        std::size_t get_bytes_batched() const;
+
+        packet_handler get_packet_handler();
+
+    private:
+
+        void append
+        (
+            void const *,
+            std::size_t
+        );
+
+        std::size_t             maxEntries_;
+
+        std::size_t             maxBytes_;
+
+        batch_handler           batchHandler_;
+
+        packet_release_handler  packetReleaseHandler_;
+
+        std::vector<packet_type> packets_;
+
+        std::vector<iovec>      iovecs_;
+
+        std::size_t             bytesBatched_{0};
+
+    }; // class packet_batcher
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::packet_batcher<T>::packet_batcher
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    maxEntries_((config.maxEntries_ == 0) ? default_max_entries : config.maxEntries_),
+    maxBytes_((config.maxBytes_ == 0) ? std::numeric_limits<std::size_t>::max() : config.maxBytes_),
+    batchHandler_(std::move(eventHandlers.batchHandler_)),
+    packetReleaseHandler_(std::move(eventHandlers.packetReleaseHandler_))
+{
+    // the iovecs point into the packets so the packets must never be relocated while batched
+    packets_.reserve(maxEntries_);
+    iovecs_.reserve(maxEntries_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::packet_batcher<T>::~packet_batcher
+(
+)
+{
+    flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::packet_batcher<T>::push
+(
+    packet_type && packet
+)
+{
+    if (packet.empty())
+        return;
+    packets_.push_back(std::move(packet));
+    append(packets_.back().data(), packets_.back().size());
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::packet_batcher<T>::attach
+(
+    std::span<char const> payload
+)
+{
+    if (!payload.empty())
+        append(payload.data(), payload.size());
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::packet_batcher<T>::append
+(
+    void const * address,
+    std::size_t size
+)
+{
+    iovecs_.push_back({const_cast<void *>(address), size});
+    bytesBatched_ += size;
+    if ((iovecs_.size() >= maxEntries_) || (bytesBatched_ >= maxBytes_))
+        flush();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::packet_batcher<T>::flush
+(
+)
+{
+    if (iovecs_.empty())
+        return;
+    if (batchHandler_)
+        batchHandler_(iovecs_);
+    iovecs_.clear();
+    bytesBatched_ = 0;
+    for (auto & packet : packets_)
+        if (packetReleaseHandler_)
+            packetReleaseHandler_(std::move(packet));
+    packets_.clear();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::packet_batcher<T>::size
+(
+) const
+{
+    return iovecs_.size();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::packet_batcher<T>::get_bytes_batched
+(
+) const
+{
+    return bytesBatched_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::packet_batcher<T>::get_packet_handler
+(
+) -> packet_handler
+{
+    return {*this};
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // bounded, thread safe pool of packets.  plugs into both the transmitter's packet allocate handler
+    // and the receiver's packet discard handler so that consumed packets return to the producer with
+    // their capacity intact rather than being destroyed and reallocated at packet rate.
+    template <packet_concept T>
+    class packet_pool :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+
+        static auto constexpr default_capacity = (1 << 10);
+
+        struct configuration
+        {
+            std::size_t capacity_ = default_capacity; // maximum number of pooled packets
+        };
+
+        struct statistics
+        {
+            std::size_t hits_{0};       // allocations served from the pool
+            std::size_t misses_{0};     // allocations which required a new packet
+            std::size_t returns_{0};    // packets returned to the pool
+            std::size_t drops_{0};      // packets destroyed because the pool was full
+        };
+
+        packet_pool
+        (
+            configuration const &
+        );
+
+        packet_type get
+        (
+            std::size_t
+        );
+
+        void put
+        (
+            packet_type &&
+        );
+
+        statistics get_statistics() const;
+
+        std::size_t size() const;
+
+        // handler for transmitter::event_handlers::packetAllocateHandler_
+        auto get_packet_allocate_handler()
+        {
+            return [this](auto const &, std::size_t capacity){return get(capacity);};
+        }
+
+        // handler for receiver::event_handlers::packetDiscardHandler_
+        auto get_packet_discard_handler()
+        {
+            return [this](auto const &, packet_type && packet){put(std::move(packet));};
+        }
+
+    private:
+
+        std::size_t                 capacity_;
+
+        std::vector<packet_type>    packets_;
+
+        statistics                  statistics_;
+
+        std::mutex mutable          mutex_;
+
+    }; // class packet_pool
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::packet_pool<T>::packet_pool
+(
+    configuration const & config
+):
+    capacity_(config.capacity_)
+{
+    packets_.reserve(capacity_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::packet_pool<T>::get
+(
+    std::size_t capacity
+) -> packet_type
+{
+    packet_type packet;
+    {
+        std::lock_guard lockGuard(mutex_);
+        if (packets_.empty())
+        {
+            ++statistics_.misses_;
+        }
+        else
+        {
+            // most recently returned first as it is the most likely to still be in cache
+            ++statistics_.hits_;
+            packet = std::move(packets_.back());
+            packets_.pop_back();
+        }
+    }
+    if constexpr (requires (packet_type packet){packet.reserve(capacity);})
+        packet.reserve(capacity);
+    else if (packet.capacity() < capacity)
+        packet = packet_type(capacity);
+    return packet;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::packet_pool<T>::put
+(
+    packet_type && packet
+)
+{
+    if constexpr (requires (packet_type packet){packet.clear();})
+        packet.clear();
+    else
+        packet.resize(0);
+
+    std::lock_guard lockGuard(mutex_);
+    if (packets_.size() < capacity_)
+    {
+        ++statistics_.returns_;
+        packets_.push_back(std::move(packet));
+    }
+    else
+    {
+        ++statistics_.drops_; // packet is destroyed when it goes out of scope
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::packet_pool<T>::get_statistics
+(
+) const -> statistics
+{
+    std::lock_guard lockGuard(mutex_);
+    return statistics_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::packet_pool<T>::size
+(
+) const
+{
+    std::lock_guard lockGuard(mutex_);
+    return packets_.size();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <cstddef>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // a non owning packet over externally managed memory (such as a shared memory ring or a memory 
+    // mapped journal).  it satisfies packet_concept so that it can be used by both the transmitter and the
+    // receiver but it can never grow beyond the capacity of the memory which it views.
+    class packet_view
+    {
+    public:
+
+        using value_type = char;
+        using size_type = std::size_t;
+        using iterator = char *;
+        using const_iterator = char const *;
+
+        packet_view() = default;
+
+        packet_view
+        (
+            char * data,
+            std::size_t size,
+            std::size_t capacity
+        ):
+            data_(data),
+            size_(size),
+            capacity_(capacity)
+        {
+        }
+
+        char * data(){return data_;}
+        char const * data() const{return data_;}
+
+        iterator begin(){return data_;}
+        const_iterator begin() const{return data_;}
+
+        iterator end(){return data_ + size_;}
+        const_iterator end() const{return data_ + size_;}
+
+        std::size_t size() const{return size_;}
+
+        bool empty() const{return (size_ == 0);}
+
+        std::size_t capacity() const{return capacity_;}
+
+        void clear(){size_ = 0;}
+
+        // NOTE: the size must not exceed the capacity of the view.  new bytes are never initialized.
+        void resize(std::size_t size){size_ = size;}
+
+        void resize_uninitialized(std::size_t size){size_ = size;}
+
+    private:
+
+        char *          data_{nullptr};
+
+        std::size_t     size_{0};
+
+        std::size_t     capacity_{0};
+
+    }; // class packet_view
+
+} // namespace bcpp::message
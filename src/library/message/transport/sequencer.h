@@ -0,0 +1,236 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // framing layer for unreliable transports (such as udp or multicast).  every packet begins with a
+    // sequence_header which occupies the packet headroom (configure both the transmitter and the receiver
+    // with packetHeadroom_ = sizeof(sequence_header)).  sequence numbers begin at one.
+    struct sequence_header
+    {
+        std::uint64_t sequence_;
+    };
+
+
+    //=========================================================================
+    // stamps each packet handed off by the transmitter (on flush) with the next sequence number, sends it
+    // and retains it in a bounded retransmit ring so that packets which the far side reports missing can be
+    // sent again.  a packet is handed to the packet release handler (for instance packet_pool::put) once it
+    // is evicted from the ring (or at once if it is too short to be framed).  not thread safe: call 
+    // retransmit() from the transmitting thread.
+    template <packet_concept T>
+    class sequencer :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+
+        static auto constexpr packet_headroom = sizeof(sequence_header);
+        static auto constexpr default_retransmit_capacity = (1 << 10);
+
+        struct configuration
+        {
+            std::size_t     retransmitCapacity_ = default_retransmit_capacity;  // packets retained for retransmission
+        };
+
+        // puts a (sequenced) packet on the wire
+        using send_handler = std::function<void(std::span<char const>)>;
+        using packet_release_handler = std::function<void(packet_type &&)>;
+
+        struct event_handlers
+        {
+            send_handler            sendHandler_;
+            packet_release_handler  packetReleaseHandler_;
+        };
+
+        struct statistics
+        {
+            std::size_t     sent_{0};
+            std::size_t     retransmitted_{0};
+            std::size_t     unavailable_{0};    // requested packets which had already left the retransmit ring
+        };
+
+        sequencer
+        (
+            configuration const &,
+            event_handlers
+        );
+
+        ~sequencer();
+
+        void push
+        (
+            packet_type &&
+        );
+
+        // send the packets [first, first + count) again.  returns false if any of them have already left
+        // the retransmit ring (the far side can not recover those packets from this sequencer).
+        bool retransmit
+        (
+            std::uint64_t first,
+            std::size_t count
+        );
+
+        std::uint64_t get_next_sequence() const;
+
+        statistics get_statistics() const;
+
+        // handler for transmitter::event_handlers::packetHandler_
+        auto get_packet_handler()
+        {
+            return [this](auto const &, packet_type packet){push(std::move(packet));};
+        }
+
+    private:
+
+        void send
+        (
+            packet_type const &
+        );
+
+        std::size_t                 mask_;
+
+        std::vector<packet_type>    retransmitRing_;
+
+        std::uint64_t               nextSequence_{1};
+
+        send_handler                sendHandler_;
+
+        packet_release_handler      packetReleaseHandler_;
+
+        statistics                  statistics_;
+
+    }; // class sequencer
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::sequencer<T>::sequencer
+(
+    configuration const & config,
+    event_handlers eventHandlers
+):
+    mask_(std::bit_ceil(std::max<std::size_t>(config.retransmitCapacity_, 1)) - 1),
+    retransmitRing_(mask_ + 1),
+    sendHandler_(std::move(eventHandlers.sendHandler_)),
+    packetReleaseHandler_(std::move(eventHandlers.packetReleaseHandler_))
+{
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::sequencer<T>::~sequencer
+(
+)
+{
+    if (packetReleaseHandler_)
+        for (auto & packet : retransmitRing_)
+            if (!packet.empty())
+                packetReleaseHandler_(std::move(packet));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::sequencer<T>::push
+(
+    packet_type && packet
+)
+{
+    if (packet.size() < packet_headroom)
+    {
+        // not a framed packet.  nothing is sent but the packet is still returned (such as to its pool).
+        if (packetReleaseHandler_)
+            packetReleaseHandler_(std::move(packet));
+        return;
+    }
+    auto sequence = nextSequence_++;
+    std::memcpy(packet.data() + offsetof(sequence_header, sequence_), &sequence, sizeof(sequence));
+    send(packet);
+    ++statistics_.sent_;
+
+    // retain the packet in place of the packet which is now too old to be retransmitted
+    auto & slot = retransmitRing_[sequence & mask_];
+    if ((!slot.empty()) && (packetReleaseHandler_))
+        packetReleaseHandler_(std::move(slot));
+    slot = std::move(packet);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::sequencer<T>::retransmit
+(
+    std::uint64_t first,
+    std::size_t count
+)
+{
+    // only the most recent 'capacity' packets remain in the ring
+    auto oldest = (nextSequence_ > retransmitRing_.size()) ? (nextSequence_ - retransmitRing_.size()) : 1;
+    auto last = std::min<std::uint64_t>(first + count, nextSequence_);
+    bool available = true;
+    for (auto sequence = first; sequence < last; ++sequence)
+    {
+        if (sequence < oldest)
+        {
+            ++statistics_.unavailable_;
+            available = false;
+            continue;
+        }
+        send(retransmitRing_[sequence & mask_]);
+        ++statistics_.retransmitted_;
+    }
+    return available;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::sequencer<T>::send
+(
+    packet_type const & packet
+)
+{
+    if (sendHandler_)
+        sendHandler_(std::span(reinterpret_cast<char const *>(packet.data()), packet.size()));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::uint64_t bcpp::message::sequencer<T>::get_next_sequence
+(
+) const
+{
+    return nextSequence_;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::sequencer<T>::get_statistics
+(
+) const -> statistics
+{
+    return statistics_;
+}
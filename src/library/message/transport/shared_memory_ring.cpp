@@ -0,0 +1,329 @@
+#include "./shared_memory_ring.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <new>
+
+
+namespace
+{
+
+    //=========================================================================
+    // process shared (not FUTEX_PRIVATE) since the waiter and the waker are in different processes
+    void futex_wait
+    (
+        std::atomic<std::uint32_t> & word,
+        std::uint32_t expected,
+        std::chrono::nanoseconds timeout
+    )
+    {
+        timespec ts{static_cast<time_t>(timeout.count() / 1'000'000'000), static_cast<long>(timeout.count() % 1'000'000'000)};
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+    }
+
+
+    //=========================================================================
+    void futex_wake
+    (
+        std::atomic<std::uint32_t> & word
+    )
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+
+
+    //=========================================================================
+    inline void cpu_relax
+    (
+    )
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+        #endif
+    }
+
+    // a parked side wakes periodically to notice that the ring has been closed
+    auto constexpr park_timeout = std::chrono::milliseconds(10);
+
+} // namespace
+
+
+//=============================================================================
+bcpp::message::shared_memory_ring::shared_memory_ring
+(
+    configuration const & config
+):
+    config_(config),
+    pageSize_(static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)))
+{
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "cursors must be address free to be shared between processes");
+
+    auto controlSize = ((sizeof(control_block) + pageSize_ - 1) & ~(pageSize_ - 1));
+    int fd = -1;
+    if (config_.openMode_ == open_mode::create)
+    {
+        capacity_ = ((std::max<std::size_t>(config_.capacity_, pageSize_) + pageSize_ - 1) & ~(pageSize_ - 1));
+        if (config_.name_.empty())
+        {
+            fd = ::memfd_create("bcpp_message_ring", MFD_CLOEXEC);
+        }
+        else
+        {
+            ::shm_unlink(config_.name_.c_str());
+            fd = ::shm_open(config_.name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+        if (fd == -1)
+            return;
+        if ((::ftruncate(fd, controlSize + capacity_) != 0) || (!map(fd, controlSize)))
+        {
+            ::close(fd);
+            return;
+        }
+        controlBlock_ = new (mapping_) control_block{};
+        controlBlock_->capacity_ = capacity_;
+        std::atomic_thread_fence(std::memory_order_release);
+        controlBlock_->magic_ = magic;
+    }
+    else
+    {
+        if (config_.name_.empty())
+            return;
+        if (fd = ::shm_open(config_.name_.c_str(), O_RDWR, 0); fd == -1)
+            return;
+        struct stat status;
+        if ((::fstat(fd, &status) != 0) || (static_cast<std::size_t>(status.st_size) <= controlSize))
+        {
+            ::close(fd);
+            return;
+        }
+        capacity_ = (status.st_size - controlSize);
+        if (!map(fd, controlSize))
+        {
+            ::close(fd);
+            return;
+        }
+        controlBlock_ = reinterpret_cast<control_block *>(mapping_);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((controlBlock_->magic_ != magic) || (controlBlock_->capacity_ != capacity_))
+        {
+            ::munmap(mapping_, mappingSize_);
+            mapping_ = nullptr;
+            controlBlock_ = nullptr;
+            ::close(fd);
+            return;
+        }
+        // consume from the first unreleased byte (the producer may already be running)
+        head_ = controlBlock_->head_.load(std::memory_order_acquire);
+        cachedTail_ = cachedHead_ = readCursor_ = controlBlock_->tail_.load(std::memory_order_acquire);
+    }
+    ::close(fd); // the mapping keeps the shared memory object alive
+}
+
+
+//=============================================================================
+bcpp::message::shared_memory_ring::~shared_memory_ring
+(
+)
+{
+    if (mapping_ != nullptr)
+        ::munmap(mapping_, mappingSize_);
+    if ((config_.openMode_ == open_mode::create) && (!config_.name_.empty()))
+        ::shm_unlink(config_.name_.c_str());
+}
+
+
+//=============================================================================
+bool bcpp::message::shared_memory_ring::map
+(
+    int fd,
+    std::size_t controlSize
+)
+{
+    // reserve the address space for the control page followed by two copies of the data pages and then
+    // map the shared memory object over the reservation
+    mappingSize_ = (controlSize + (capacity_ * 2));
+    auto reservation = ::mmap(nullptr, mappingSize_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reservation == MAP_FAILED)
+        return false;
+    auto base = reinterpret_cast<char *>(reservation);
+    if ((::mmap(base, controlSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+        (::mmap(base + controlSize, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, controlSize) == MAP_FAILED) ||
+        (::mmap(base + controlSize + capacity_, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, controlSize) == MAP_FAILED))
+    {
+        ::munmap(reservation, mappingSize_);
+        return false;
+    }
+    mapping_ = reservation;
+    data_ = base + controlSize;
+    return true;
+}
+
+
+//=============================================================================
+bool bcpp::message::shared_memory_ring::is_valid
+(
+) const
+{
+    return (controlBlock_ != nullptr);
+}
+
+
+//=============================================================================
+std::size_t bcpp::message::shared_memory_ring::capacity
+(
+) const
+{
+    return capacity_;
+}
+
+
+//=============================================================================
+auto bcpp::message::shared_memory_ring::allocate
+(
+    std::size_t capacity
+) -> packet_view
+{
+    if (!is_valid())
+        return {};
+    capacity = std::min(capacity, capacity_ - sizeof(frame_header));
+    auto hasSpace = [&](){return ((capacity_ - (head_ - cachedTail_)) >= frame_size(capacity));};
+    if (!hasSpace())
+    {
+        for (std::size_t i = 0; i < config_.spinCount_; ++i)
+        {
+            cachedTail_ = controlBlock_->tail_.load(std::memory_order_acquire);
+            if (hasSpace())
+                break;
+            cpu_relax();
+        }
+        while (!hasSpace())
+        {
+            if (controlBlock_->closed_.load(std::memory_order_acquire) != 0)
+                return {};
+            // announce that we are parking then check once more before doing so.  the consumer stores
+            // the tail before checking for a parked producer so one side or the other sees the update.
+            auto signal = controlBlock_->spaceSignal_.load(std::memory_order_acquire);
+            controlBlock_->producerWaiting_.store(1, std::memory_order_seq_cst);
+            cachedTail_ = controlBlock_->tail_.load(std::memory_order_seq_cst);
+            if (!hasSpace())
+                futex_wait(controlBlock_->spaceSignal_, signal, park_timeout);
+            controlBlock_->producerWaiting_.store(0, std::memory_order_relaxed);
+            cachedTail_ = controlBlock_->tail_.load(std::memory_order_acquire);
+        }
+    }
+    return {data_ + (head_ % capacity_) + sizeof(frame_header), 0, capacity};
+}
+
+
+//=============================================================================
+void bcpp::message::shared_memory_ring::commit
+(
+    packet_view const & packet
+)
+{
+    if ((!is_valid()) || (packet.empty()))
+        return;
+    reinterpret_cast<frame_header *>(data_ + (head_ % capacity_))->size_ = packet.size();
+    head_ += frame_size(packet.size());
+    controlBlock_->head_.store(head_, std::memory_order_seq_cst);
+    if (controlBlock_->consumerWaiting_.load(std::memory_order_seq_cst) != 0)
+    {
+        controlBlock_->dataSignal_.fetch_add(1, std::memory_order_release);
+        futex_wake(controlBlock_->dataSignal_);
+    }
+}
+
+
+//=============================================================================
+void bcpp::message::shared_memory_ring::close
+(
+)
+{
+    if (!is_valid())
+        return;
+    controlBlock_->closed_.store(1, std::memory_order_seq_cst);
+    controlBlock_->dataSignal_.fetch_add(1, std::memory_order_release);
+    futex_wake(controlBlock_->dataSignal_);
+    controlBlock_->spaceSignal_.fetch_add(1, std::memory_order_release);
+    futex_wake(controlBlock_->spaceSignal_);
+}
+
+
+//=============================================================================
+auto bcpp::message::shared_memory_ring::poll
+(
+) -> packet_view
+{
+    if (!is_valid())
+        return {};
+    if (cachedHead_ == readCursor_)
+        if (cachedHead_ = controlBlock_->head_.load(std::memory_order_acquire); cachedHead_ == readCursor_)
+            return {};
+    // a frame never exceeds the capacity so the view lies within the mirrored mapping
+    auto frame = (data_ + (readCursor_ % capacity_));
+    auto size = reinterpret_cast<frame_header const *>(frame)->size_;
+    readCursor_ += frame_size(size);
+    return {frame + sizeof(frame_header), size, size};
+}
+
+
+//=============================================================================
+auto bcpp::message::shared_memory_ring::wait
+(
+    std::chrono::nanoseconds timeout
+) -> packet_view
+{
+    if (auto packet = poll(); !packet.empty())
+        return packet;
+    for (std::size_t i = 0; i < config_.spinCount_; ++i)
+    {
+        if (auto packet = poll(); !packet.empty())
+            return packet;
+        cpu_relax();
+    }
+    if (!is_valid())
+        return {};
+    // same protocol as the producer's wait for space
+    auto signal = controlBlock_->dataSignal_.load(std::memory_order_acquire);
+    controlBlock_->consumerWaiting_.store(1, std::memory_order_seq_cst);
+    cachedHead_ = controlBlock_->head_.load(std::memory_order_seq_cst);
+    if ((cachedHead_ == readCursor_) && (controlBlock_->closed_.load(std::memory_order_acquire) == 0))
+        futex_wait(controlBlock_->dataSignal_, signal, timeout);
+    controlBlock_->consumerWaiting_.store(0, std::memory_order_relaxed);
+    return poll();
+}
+
+
+//=============================================================================
+void bcpp::message::shared_memory_ring::release
+(
+    packet_view const & packet
+)
+{
+    if ((!is_valid()) || (packet.empty()))
+        return;
+    auto tail = controlBlock_->tail_.load(std::memory_order_relaxed) + frame_size(packet.size());
+    controlBlock_->tail_.store(tail, std::memory_order_seq_cst);
+    if (controlBlock_->producerWaiting_.load(std::memory_order_seq_cst) != 0)
+    {
+        controlBlock_->spaceSignal_.fetch_add(1, std::memory_order_release);
+        futex_wake(controlBlock_->spaceSignal_);
+    }
+}
+
+
+//=============================================================================
+bool bcpp::message::shared_memory_ring::is_closed
+(
+) const
+{
+    return ((is_valid()) && (controlBlock_->closed_.load(std::memory_order_acquire) != 0) && 
+            (controlBlock_->head_.load(std::memory_order_acquire) == readCursor_));
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "./packet_view.h"
+
+#include <include/non_copyable.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // single producer single consumer byte ring in shared memory for passing messages between processes
+    // on the same host.  the ring's data pages are mapped twice, back to back, so that any region of the
+    // ring (even one which wraps) is contiguous in memory.  this allows the transmitter to serialize 
+    // directly into the ring and the receiver to dispatch directly out of it without copying.
+    //
+    // producer: use get_packet_allocate_handler() and get_packet_handler() as the transmitter's handlers 
+    //           with packet_view as the transmitter's packet type.  allocation blocks (spin then park)
+    //           until the consumer has released enough space.
+    // consumer: poll() (or wait()) for a packet_view of the next committed packet and push it into a 
+    //           receiver whose packets are packet_views.  use get_packet_discard_handler() as the receiver's 
+    //           discard handler so that consumed bytes are released back to the producer.
+    //
+    // each commit is framed by a small length prefix so packet boundaries are preserved and poll() returns
+    // exactly the packets which were committed (receivers configured with packetHeadroom_ or tracePackets_
+    // rely on every packet beginning with its prefix).
+    //
+    // the head (committed) and tail (released) cursors are lock free and each side caches the other's
+    // cursor.  a side which runs out of data (consumer) or space (producer) spins briefly and then parks
+    // on a futex which the other side only wakes (a system call) when it knows the waiter is parked.
+    class shared_memory_ring :
+        non_copyable
+    {
+    public:
+
+        static auto constexpr default_capacity = (1 << 20);
+        static auto constexpr default_spin_count = (1 << 12);
+
+        enum class open_mode
+        {
+            create,     // create (or replace) the shared memory object
+            open        // open a shared memory object created by another process
+        };
+
+        struct configuration
+        {
+            // name of the posix shared memory object ("/name").  an empty name creates an anonymous ring
+            // (memfd) which can only be shared with child processes.
+            std::string     name_;
+            open_mode       openMode_{open_mode::create};
+            std::size_t     capacity_{default_capacity}; // rounded up to a multiple of the page size.  ignored by open.
+            std::size_t     spinCount_{default_spin_count};
+        };
+
+        shared_memory_ring
+        (
+            configuration const &
+        );
+
+        // the creator of a named ring also removes the name
+        ~shared_memory_ring();
+
+        bool is_valid() const;
+
+        std::size_t capacity() const;
+
+        // producer: a view of 'capacity' writable bytes at the head of the ring.  blocks until that much
+        // space is available (the request is limited to the capacity of the ring less the frame header).
+        // returns an empty view if the ring has been closed.
+        packet_view allocate
+        (
+            std::size_t capacity
+        );
+
+        // producer: publish the bytes of the most recently allocated view (its size, not its capacity)
+        void commit
+        (
+            packet_view const &
+        );
+
+        // producer: mark the end of the stream and wake the consumer
+        void close();
+
+        // consumer: a view of the next committed packet (empty if none)
+        packet_view poll();
+
+        // consumer: poll, spinning then parking for up to 'timeout' if there is nothing to consume
+        packet_view wait
+        (
+            std::chrono::nanoseconds timeout
+        );
+
+        // consumer: return the bytes of a consumed view to the producer.  views must be released in order.
+        void release
+        (
+            packet_view const &
+        );
+
+        // consumer: true once the producer has closed the ring and every committed byte has been polled
+        bool is_closed() const;
+
+        // handler for transmitter::event_handlers::packetAllocateHandler_
+        auto get_packet_allocate_handler()
+        {
+            return [this](auto const &, std::size_t capacity){return allocate(capacity);};
+        }
+
+        // handler for transmitter::event_handlers::packetHandler_
+        auto get_packet_handler()
+        {
+            return [this](auto const &, packet_view packet){commit(packet);};
+        }
+
+        // handler for receiver::event_handlers::packetDiscardHandler_
+        auto get_packet_discard_handler()
+        {
+            return [this](auto const &, packet_view && packet){release(packet);};
+        }
+
+    private:
+
+        static auto constexpr cache_line_size = 64;
+        static auto constexpr magic = std::uint64_t(0x62637070'72696e67); // "bcppring"
+
+        // precedes every committed packet.  frames are padded to a multiple of the header size so that
+        // every header is aligned.
+        struct frame_header
+        {
+            std::uint64_t   size_;
+        };
+
+        static constexpr std::uint64_t frame_size
+        (
+            std::size_t packetSize
+        )
+        {
+            return (sizeof(frame_header) + ((packetSize + sizeof(frame_header) - 1) & ~(sizeof(frame_header) - 1)));
+        }
+
+        // resides in the first page of the shared memory object
+        struct control_block
+        {
+            std::uint64_t                                       magic_;
+            std::uint64_t                                       capacity_;
+            std::atomic<std::uint32_t>                          closed_;
+
+            // written by the producer
+            alignas(cache_line_size) std::atomic<std::uint64_t> head_;
+            std::atomic<std::uint32_t>                          dataSignal_;
+            std::atomic<std::uint32_t>                          producerWaiting_;
+
+            // written by the consumer
+            alignas(cache_line_size) std::atomic<std::uint64_t> tail_;
+            std::atomic<std::uint32_t>                          spaceSignal_;
+            std::atomic<std::uint32_t>                          consumerWaiting_;
+        };
+
+        bool map
+        (
+            int,
+            std::size_t
+        );
+
+        configuration           config_;
+
+        std::size_t             pageSize_;
+
+        std::size_t             capacity_{0};
+
+        std::size_t             mappingSize_{0};
+
+        void *                  mapping_{nullptr};
+
+        control_block *         controlBlock_{nullptr};
+
+        char *                  data_{nullptr};
+
+        // producer's cache line
+        alignas(cache_line_size) std::uint64_t  head_{0};
+
+        std::uint64_t           cachedTail_{0};
+
+        // consumer's cache line
+        alignas(cache_line_size) std::uint64_t  readCursor_{0};
+
+        std::uint64_t           cachedHead_{0};
+
+    }; // class shared_memory_ring
+
+} // namespace bcpp::message
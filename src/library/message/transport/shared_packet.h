@@ -0,0 +1,431 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace bcpp::message
+{
+
+    template <packet_concept T> class shared_packet_pool;
+
+
+    //=========================================================================
+    template <packet_concept T>
+    struct shared_packet_control_block
+    {
+        std::atomic<std::size_t>    references_{0};
+        T                           packet_;
+        shared_packet_pool<T> *     pool_{nullptr};
+    };
+
+
+    //=========================================================================
+    // reference counted, immutable packet.  satisfies packet_concept so it can be pushed into any number
+    // of receivers (the receiver's packet queue must hold shared_packet<T>).  every copy refers to the same
+    // buffer and the buffer returns to its shared_packet_pool when the last copy is destroyed (typically
+    // when the last receiver discards it).  a copy may additionally be tracked by an 'outstanding' counter
+    // which is incremented for as long as the copy (or any copy made from it) exists.
+    template <packet_concept T>
+    class shared_packet
+    {
+    public:
+
+        using packet_type = T;
+        using value_type = char;
+
+        shared_packet() = default;
+
+        shared_packet
+        (
+            shared_packet const &
+        );
+
+        shared_packet
+        (
+            shared_packet &&
+        ) noexcept;
+
+        shared_packet & operator =
+        (
+            shared_packet const &
+        );
+
+        shared_packet & operator =
+        (
+            shared_packet &&
+        ) noexcept;
+
+        ~shared_packet();
+
+        // another reference to the same buffer which is also tracked by the given counter
+        shared_packet share
+        (
+            std::atomic<std::size_t> &
+        ) const;
+
+        char const * data() const{return (controlBlock_ == nullptr) ? nullptr : reinterpret_cast<char const *>(controlBlock_->packet_.data());}
+        char const * begin() const{return data();}
+        char const * end() const{return data() + size();}
+        std::size_t size() const{return (controlBlock_ == nullptr) ? 0 : controlBlock_->packet_.size();}
+        bool empty() const{return (size() == 0);}
+        std::size_t capacity() const{return size();}
+
+        std::size_t use_count() const;
+
+    private:
+
+        friend class shared_packet_pool<T>;
+
+        using control_block = shared_packet_control_block<T>;
+
+        shared_packet
+        (
+            control_block *,
+            std::atomic<std::size_t> *
+        );
+
+        void acquire();
+
+        void release();
+
+        control_block *             controlBlock_{nullptr};
+
+        std::atomic<std::size_t> *  outstanding_{nullptr};
+
+    }; // class shared_packet
+
+
+    //=========================================================================
+    // thread safe pool of shared packet buffers and their control blocks.  get() provides writable packets
+    // (with their capacity intact) for the transmitter to serialize into and make_shared() seals a filled
+    // packet into a shared_packet.  control blocks are never freed while the pool exists so the pool must
+    // outlive every shared_packet which it has made.
+    template <packet_concept T>
+    class shared_packet_pool :
+        non_copyable
+    {
+    public:
+
+        using packet_type = T;
+
+        static auto constexpr default_capacity = (1 << 10);
+
+        struct configuration
+        {
+            std::size_t capacity_ = default_capacity; // maximum number of pooled packet buffers
+        };
+
+        struct statistics
+        {
+            std::size_t hits_{0};       // allocations served from the pool
+            std::size_t misses_{0};     // allocations which required a new packet
+            std::size_t returns_{0};    // buffers returned to the pool by the last reference
+            std::size_t drops_{0};      // buffers destroyed because the pool was full
+        };
+
+        shared_packet_pool
+        (
+            configuration const &
+        );
+
+        packet_type get
+        (
+            std::size_t
+        );
+
+        shared_packet<T> make_shared
+        (
+            packet_type &&
+        );
+
+        statistics get_statistics() const;
+
+        // handler for transmitter::event_handlers::packetAllocateHandler_
+        auto get_packet_allocate_handler()
+        {
+            return [this](auto const &, std::size_t capacity){return get(capacity);};
+        }
+
+    private:
+
+        friend class shared_packet<T>;
+
+        using control_block = shared_packet_control_block<T>;
+
+        void release
+        (
+            control_block *
+        );
+
+        std::size_t                                     capacity_;
+
+        std::vector<std::unique_ptr<control_block>>     controlBlocks_;
+
+        std::vector<control_block *>                    pooled_;        // control blocks holding a recycled buffer
+
+        std::vector<control_block *>                    unused_;        // control blocks without a buffer
+
+        statistics                                      statistics_;
+
+        std::mutex mutable                              mutex_;
+
+    }; // class shared_packet_pool
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::shared_packet<T>::shared_packet
+(
+    control_block * controlBlock,
+    std::atomic<std::size_t> * outstanding
+):
+    controlBlock_(controlBlock),
+    outstanding_(outstanding)
+{
+    acquire();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::shared_packet<T>::shared_packet
+(
+    shared_packet const & other
+):
+    controlBlock_(other.controlBlock_),
+    outstanding_(other.outstanding_)
+{
+    acquire();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::shared_packet<T>::shared_packet
+(
+    shared_packet && other
+) noexcept:
+    controlBlock_(std::exchange(other.controlBlock_, nullptr)),
+    outstanding_(std::exchange(other.outstanding_, nullptr))
+{
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet<T>::operator =
+(
+    shared_packet const & other
+) -> shared_packet &
+{
+    if (this != &other)
+    {
+        release();
+        controlBlock_ = other.controlBlock_;
+        outstanding_ = other.outstanding_;
+        acquire();
+    }
+    return *this;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet<T>::operator =
+(
+    shared_packet && other
+) noexcept -> shared_packet &
+{
+    if (this != &other)
+    {
+        release();
+        controlBlock_ = std::exchange(other.controlBlock_, nullptr);
+        outstanding_ = std::exchange(other.outstanding_, nullptr);
+    }
+    return *this;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::shared_packet<T>::~shared_packet
+(
+)
+{
+    release();
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet<T>::share
+(
+    std::atomic<std::size_t> & outstanding
+) const -> shared_packet
+{
+    return {controlBlock_, &outstanding};
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::shared_packet<T>::use_count
+(
+) const
+{
+    return (controlBlock_ == nullptr) ? 0 : controlBlock_->references_.load(std::memory_order_relaxed);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+inline void bcpp::message::shared_packet<T>::acquire
+(
+)
+{
+    if (controlBlock_ != nullptr)
+        controlBlock_->references_.fetch_add(1, std::memory_order_relaxed);
+    if (outstanding_ != nullptr)
+        outstanding_->fetch_add(1, std::memory_order_relaxed);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+inline void bcpp::message::shared_packet<T>::release
+(
+)
+{
+    if (outstanding_ != nullptr)
+        std::exchange(outstanding_, nullptr)->fetch_sub(1, std::memory_order_release);
+    if (controlBlock_ != nullptr)
+    {
+        // the last reference returns the buffer.  acquire the writes made via every other reference first.
+        auto controlBlock = std::exchange(controlBlock_, nullptr);
+        if (controlBlock->references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            controlBlock->pool_->release(controlBlock);
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::shared_packet_pool<T>::shared_packet_pool
+(
+    configuration const & config
+):
+    capacity_(config.capacity_)
+{
+    pooled_.reserve(capacity_);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet_pool<T>::get
+(
+    std::size_t capacity
+) -> packet_type
+{
+    packet_type packet;
+    {
+        std::lock_guard lockGuard(mutex_);
+        if (pooled_.empty())
+        {
+            ++statistics_.misses_;
+        }
+        else
+        {
+            // most recently returned first as it is the most likely to still be in cache.  the control
+            // block is kept for the next make_shared().
+            ++statistics_.hits_;
+            auto controlBlock = pooled_.back();
+            pooled_.pop_back();
+            packet = std::move(controlBlock->packet_);
+            unused_.push_back(controlBlock);
+        }
+    }
+    if constexpr (requires (packet_type packet){packet.reserve(capacity);})
+        packet.reserve(capacity);
+    else if (packet.capacity() < capacity)
+        packet = packet_type(capacity);
+    return packet;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet_pool<T>::make_shared
+(
+    packet_type && packet
+) -> shared_packet<T>
+{
+    control_block * controlBlock = nullptr;
+    {
+        std::lock_guard lockGuard(mutex_);
+        if (unused_.empty())
+        {
+            controlBlocks_.push_back(std::make_unique<control_block>());
+            controlBlocks_.back()->pool_ = this;
+            unused_.reserve(controlBlocks_.size());
+            pooled_.reserve(controlBlocks_.size());
+            controlBlock = controlBlocks_.back().get();
+        }
+        else
+        {
+            controlBlock = unused_.back();
+            unused_.pop_back();
+        }
+    }
+    controlBlock->packet_ = std::move(packet);
+    return {controlBlock, nullptr};
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::shared_packet_pool<T>::release
+(
+    control_block * controlBlock
+)
+{
+    if constexpr (requires (packet_type packet){packet.clear();})
+        controlBlock->packet_.clear();
+    else
+        controlBlock->packet_.resize(0);
+
+    std::lock_guard lockGuard(mutex_);
+    if (pooled_.size() < capacity_)
+    {
+        ++statistics_.returns_;
+        pooled_.push_back(controlBlock);
+    }
+    else
+    {
+        ++statistics_.drops_;
+        controlBlock->packet_ = packet_type();
+        unused_.push_back(controlBlock);
+    }
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::shared_packet_pool<T>::get_statistics
+(
+) const -> statistics
+{
+    std::lock_guard lockGuard(mutex_);
+    return statistics_;
+}
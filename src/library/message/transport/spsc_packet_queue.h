@@ -0,0 +1,248 @@
+#pragma once
+
+#include "./packet.h"
+
+#include <include/non_copyable.h>
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+
+namespace bcpp::message
+{
+
+    //=========================================================================
+    // bounded lock free single producer single consumer packet queue.  satisfies packet_queue_concept.
+    // push() is called by the producer thread only.  front(), pop() and empty() are called by the
+    // consumer thread only.  each side caches the other side's index and only reloads it (a cross core
+    // cache miss) when the cached value suggests the queue is full (producer) or empty (consumer).
+    template <packet_concept T>
+    class spsc_packet_queue :
+        non_copyable
+    {
+    public:
+
+        using value_type = T;
+
+        static auto constexpr concurrent = true;
+        static auto constexpr default_capacity = (1 << 10);
+
+        explicit spsc_packet_queue
+        (
+            std::size_t = default_capacity
+        );
+
+        // returns false (leaving the packet untouched) if the queue is full
+        bool push
+        (
+            value_type &&
+        );
+
+        bool push
+        (
+            value_type const &
+        );
+
+        // push as many of the packets as will fit.  returns the number of packets pushed (moved from).
+        std::size_t push
+        (
+            std::span<value_type>
+        );
+
+        value_type & front();
+
+        void pop();
+
+        // pop up to 'count' packets.  returns the number of packets popped.
+        std::size_t pop
+        (
+            std::size_t count
+        );
+
+        bool empty() const;
+
+        std::size_t size() const;
+
+        std::size_t capacity() const;
+
+    private:
+
+        static auto constexpr cache_line_size = 64;
+
+        template <typename P>
+        bool emplace
+        (
+            P &&
+        );
+
+        std::size_t                                         capacity_;
+
+        std::size_t                                         mask_;
+
+        std::unique_ptr<value_type []>                      packets_;
+
+        // producer's cache line
+        alignas(cache_line_size) std::atomic<std::size_t>   pushIndex_{0};
+
+        std::size_t                                         cachedPopIndex_{0};
+
+        // consumer's cache line
+        alignas(cache_line_size) std::atomic<std::size_t>   popIndex_{0};
+
+        std::size_t mutable                                 cachedPushIndex_{0};
+
+    }; // class spsc_packet_queue
+
+} // namespace bcpp::message
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bcpp::message::spsc_packet_queue<T>::spsc_packet_queue
+(
+    std::size_t capacity
+):
+    capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+    mask_(capacity_ - 1),
+    packets_(std::make_unique<value_type []>(capacity_))
+{
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+template <typename P>
+bool bcpp::message::spsc_packet_queue<T>::emplace
+(
+    P && packet
+)
+{
+    auto pushIndex = pushIndex_.load(std::memory_order_relaxed);
+    if ((pushIndex - cachedPopIndex_) == capacity_)
+    {
+        cachedPopIndex_ = popIndex_.load(std::memory_order_acquire);
+        if ((pushIndex - cachedPopIndex_) == capacity_)
+            return false; // full
+    }
+    packets_[pushIndex & mask_] = std::forward<P>(packet);
+    pushIndex_.store(pushIndex + 1, std::memory_order_release);
+    return true;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::spsc_packet_queue<T>::push
+(
+    value_type && packet
+)
+{
+    return emplace(std::move(packet));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::spsc_packet_queue<T>::push
+(
+    value_type const & packet
+)
+{
+    return emplace(packet);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::spsc_packet_queue<T>::push
+(
+    std::span<value_type> packets
+)
+{
+    auto pushIndex = pushIndex_.load(std::memory_order_relaxed);
+    if ((capacity_ - (pushIndex - cachedPopIndex_)) < packets.size())
+        cachedPopIndex_ = popIndex_.load(std::memory_order_acquire);
+    auto count = std::min(packets.size(), capacity_ - (pushIndex - cachedPopIndex_));
+    for (std::size_t i = 0; i < count; ++i)
+        packets_[(pushIndex + i) & mask_] = std::move(packets[i]);
+    pushIndex_.store(pushIndex + count, std::memory_order_release); // publish the entire batch at once
+    return count;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+auto bcpp::message::spsc_packet_queue<T>::front
+(
+) -> value_type &
+{
+    return packets_[popIndex_.load(std::memory_order_relaxed) & mask_];
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+void bcpp::message::spsc_packet_queue<T>::pop
+(
+)
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    packets_[popIndex & mask_] = value_type(); // release whatever the packet still holds
+    popIndex_.store(popIndex + 1, std::memory_order_release);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::spsc_packet_queue<T>::pop
+(
+    std::size_t count
+)
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    if ((cachedPushIndex_ - popIndex) < count)
+        cachedPushIndex_ = pushIndex_.load(std::memory_order_acquire);
+    count = std::min(count, cachedPushIndex_ - popIndex);
+    for (std::size_t i = 0; i < count; ++i)
+        packets_[(popIndex + i) & mask_] = value_type();
+    popIndex_.store(popIndex + count, std::memory_order_release); // release the entire batch at once
+    return count;
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+bool bcpp::message::spsc_packet_queue<T>::empty
+(
+) const
+{
+    auto popIndex = popIndex_.load(std::memory_order_relaxed);
+    if (cachedPushIndex_ != popIndex)
+        return false;
+    cachedPushIndex_ = pushIndex_.load(std::memory_order_acquire);
+    return (cachedPushIndex_ == popIndex);
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::spsc_packet_queue<T>::size
+(
+) const
+{
+    return (pushIndex_.load(std::memory_order_acquire) - popIndex_.load(std::memory_order_acquire));
+}
+
+
+//=============================================================================
+template <bcpp::message::packet_concept T>
+std::size_t bcpp::message::spsc_packet_queue<T>::capacity
+(
+) const
+{
+    return capacity_;
+}
@@ -0,0 +1,248 @@
+#include "./test.h"
+#include "./test_protocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+
+    using namespace test;
+
+    using shared_packet_type = bcpp::message::shared_packet<packet_type>;
+    using shared_packet_pool_type = bcpp::message::shared_packet_pool<packet_type>;
+    using broadcaster_type = bcpp::message::broadcaster<packet_type>;
+    using slow_consumer_policy = broadcaster_type::slow_consumer_policy;
+
+
+    //=========================================================================
+    // a sink which consumes the broadcast packets (discarding each packet releases it)
+    class quote_recipient :
+        public bcpp::message::receiver<quote_recipient, test_protocol, std::queue<shared_packet_type>>
+    {
+    public:
+
+        quote_recipient():receiver({}, {}){}
+
+        std::vector<std::uint64_t>  values_;
+
+    private:
+
+        friend class receiver;
+
+        void operator()
+        (
+            quote_message const & quote
+        )
+        {
+            values_.push_back(std::uint64_t{quote.value_});
+        }
+    };
+
+
+    //=========================================================================
+    // publishes one packet (holding a single quote) per call through a transmitter using the
+    // broadcaster's packet pool
+    class publisher
+    {
+    public:
+
+        publisher
+        (
+            broadcaster_type & broadcaster
+        ):
+            transmitter_({}, {broadcaster.get_packet_allocate_handler(), broadcaster.get_packet_handler()})
+        {
+        }
+
+        void publish
+        (
+            std::size_t count = 1
+        )
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                transmitter_.send(quote_message(0, value_++));
+                transmitter_.flush();
+            }
+        }
+
+        std::uint64_t get_published() const{return value_;}
+
+    private:
+
+        bcpp::message::transmitter<test_protocol, packet_type> transmitter_;
+
+        std::uint64_t   value_{0};
+    };
+
+
+    //=========================================================================
+    void empty_shared_packets_have_no_data
+    (
+    )
+    {
+        shared_packet_type sharedPacket;
+        check(sharedPacket.data() == nullptr, "a default constructed packet has no data");
+        check((sharedPacket.size() == 0) && (sharedPacket.empty()) && (sharedPacket.use_count() == 0), "a default constructed packet is empty");
+
+        shared_packet_pool_type pool({});
+        auto packet = pool.get(64);
+        append(packet, quote_message(1, 2));
+        auto first = pool.make_shared(std::move(packet));
+        auto second = std::move(first);
+        check(first.data() == nullptr, "a moved from packet has no data");
+        check(first.empty(), "a moved from packet is empty");
+        check((second.data() != nullptr) && (second.size() == sizeof(quote_message)), "the moved to packet holds the buffer");
+    }
+
+
+    //=========================================================================
+    void shared_packet_pool_recycles_buffers
+    (
+    )
+    {
+        static auto constexpr pool_capacity = 2;
+        shared_packet_pool_type pool({.capacity_ = pool_capacity});
+        std::atomic<std::size_t> outstanding{0};
+        {
+            std::vector<shared_packet_type> sharedPackets;
+            for (auto i = 0; i < 3; ++i)
+            {
+                auto packet = pool.get(64);
+                append(packet, quote_message(0, i));
+                sharedPackets.push_back(pool.make_shared(std::move(packet)));
+            }
+            auto tracked = sharedPackets[0].share(outstanding);
+            auto copy = tracked;
+            check(outstanding == 2, "every tracked copy is outstanding");
+            check(sharedPackets[0].use_count() == 3, "copies share the buffer");
+            check(std::equal(copy.begin(), copy.end(), sharedPackets[0].begin()), "copies refer to the same bytes");
+        }
+        check(outstanding == 0, "released copies are no longer outstanding");
+
+        auto statistics = pool.get_statistics();
+        check(statistics.misses_ == 3, "new buffers are allocated while the pool is empty");
+        check(statistics.returns_ == pool_capacity, "released buffers return to the pool");
+        check(statistics.drops_ == 1, "buffers beyond the pool's capacity are dropped");
+
+        auto packet = pool.get(64);
+        check(pool.get_statistics().hits_ == 1, "a pooled buffer is reused");
+        check((packet.empty()) && (packet.capacity() >= 64), "a recycled buffer is empty with its capacity intact");
+    }
+
+
+    //=========================================================================
+    // a sink which holds its packets misses packets once it reaches the limit and resumes once it has
+    // released some.  the other sinks receive every packet.
+    void drop_policy_skips_a_slow_sink_until_it_catches_up
+    (
+    )
+    {
+        static auto constexpr max_outstanding_packets = 4;
+        std::vector<std::pair<std::size_t, slow_consumer_policy>> slowConsumers;
+        broadcaster_type broadcaster({.maxOutstandingPackets_ = max_outstanding_packets, .slowConsumerPolicy_ = slow_consumer_policy::drop},
+                {.slowConsumerHandler_ = [&](auto sinkId, auto policy){slowConsumers.emplace_back(sinkId, policy);}});
+
+        std::deque<shared_packet_type> held;
+        quote_recipient quoteRecipient;
+        std::size_t released = 0;
+        auto slowSink = broadcaster.add_sink([&](shared_packet_type && sharedPacket){held.push_back(std::move(sharedPacket));});
+        auto receiverSink = broadcaster.add_sink([&](shared_packet_type && sharedPacket){quoteRecipient << std::move(sharedPacket);});
+        auto releasingSink = broadcaster.add_sink([&](shared_packet_type &&){++released;}); // released immediately
+        check(broadcaster.get_sink_count() == 3, "sink count");
+
+        publisher p(broadcaster);
+        auto publish = [&](std::size_t count)
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        p.publish();
+                        quoteRecipient.process_all();
+                    }
+                };
+
+        publish(6);
+        auto statistics = broadcaster.get_sink_statistics(slowSink);
+        check((statistics.delivered_ == 4) && (statistics.dropped_ == 2) && (statistics.outstanding_ == 4), "the slow sink misses packets at the limit");
+        check(statistics.connected_, "the slow sink remains connected");
+        check((slowConsumers.size() == 1) && (slowConsumers[0] == std::make_pair(slowSink, slow_consumer_policy::drop)), "the first packet missed is reported");
+
+        held.pop_front();
+        held.pop_front();
+        check(broadcaster.get_sink_statistics(slowSink).outstanding_ == 2, "released packets are no longer outstanding");
+        publish(4);
+        statistics = broadcaster.get_sink_statistics(slowSink);
+        check((statistics.delivered_ == 6) && (statistics.dropped_ == 4), "the slow sink resumes once below the limit");
+        check(slowConsumers.size() == 2, "each run of missed packets is reported once");
+
+        for (auto sinkId : {receiverSink, releasingSink})
+        {
+            statistics = broadcaster.get_sink_statistics(sinkId);
+            check((statistics.delivered_ == p.get_published()) && (statistics.dropped_ == 0) && (statistics.outstanding_ == 0), "other sinks are not stalled");
+        }
+        check(released == p.get_published(), "the releasing sink sees every packet");
+        check(quoteRecipient.values_.size() == p.get_published(), "the receiver sink consumes every message");
+
+        held.clear();
+        check(broadcaster.get_sink_statistics(slowSink).outstanding_ == 0, "nothing is outstanding once released");
+        auto poolStatistics = broadcaster.get_packet_pool_statistics();
+        check(poolStatistics.returns_ == p.get_published(), "every buffer returns to the pool");
+        check(poolStatistics.hits_ > 0, "buffers are recycled by the transmitter");
+        check((poolStatistics.hits_ + poolStatistics.misses_) >= p.get_published(), "every packet is allocated from the pool");
+    }
+
+
+    //=========================================================================
+    // a sink which reaches the limit is removed.  packets which it still holds remain valid and are
+    // released as usual.
+    void disconnect_policy_removes_a_slow_sink
+    (
+    )
+    {
+        static auto constexpr max_outstanding_packets = 2;
+        std::vector<std::pair<std::size_t, slow_consumer_policy>> slowConsumers;
+        broadcaster_type broadcaster({.maxOutstandingPackets_ = max_outstanding_packets, .slowConsumerPolicy_ = slow_consumer_policy::disconnect},
+                {.slowConsumerHandler_ = [&](auto sinkId, auto policy){slowConsumers.emplace_back(sinkId, policy);}});
+
+        std::deque<shared_packet_type> held;
+        std::size_t released = 0;
+        auto slowSink = broadcaster.add_sink([&](shared_packet_type && sharedPacket){held.push_back(std::move(sharedPacket));});
+        auto releasingSink = broadcaster.add_sink([&](shared_packet_type &&){++released;});
+
+        publisher p(broadcaster);
+        p.publish(5);
+        auto statistics = broadcaster.get_sink_statistics(slowSink);
+        check((!statistics.connected_) && (statistics.delivered_ == max_outstanding_packets), "the slow sink is removed at the limit");
+        check(broadcaster.get_sink_count() == 1, "sink count excludes the removed sink");
+        check((slowConsumers.size() == 1) && (slowConsumers[0] == std::make_pair(slowSink, slow_consumer_policy::disconnect)), "the removal is reported");
+        check((held.size() == max_outstanding_packets) && (held.back().size() == sizeof(quote_message)), "held packets remain valid");
+        check((broadcaster.get_sink_statistics(releasingSink).delivered_ == 5) && (released == 5), "the other sink is not stalled");
+
+        held.clear();
+        check(broadcaster.get_sink_statistics(slowSink).outstanding_ == 0, "packets of a removed sink are released");
+        check(broadcaster.get_packet_pool_statistics().returns_ == 5, "every buffer returns to the pool");
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    empty_shared_packets_have_no_data();
+    shared_packet_pool_recycles_buffers();
+    drop_policy_skips_a_slow_sink_until_it_catches_up();
+    disconnect_policy_removes_a_slow_sink();
+    return test::report("broadcaster_test");
+}
@@ -0,0 +1,248 @@
+#include "./test.h"
+
+#include <library/message.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+
+namespace test
+{
+
+    // bulk messages use the default lane (zero).  orders and cancels declare more urgent lanes.
+    enum class lane_message_indicator : std::uint8_t
+    {
+        bulk = 1,
+        order = 2,
+        cancel = 3
+    };
+
+    using lane_protocol = bcpp::message::protocol
+            <
+                bcpp::message::protocol_traits<"lane_test_protocol", {1, 0, 'a'}, lane_message_indicator>,
+                lane_message_indicator::bulk,
+                lane_message_indicator::order,
+                lane_message_indicator::cancel
+            >;
+
+} // namespace test
+
+
+namespace bcpp::message
+{
+
+    #pragma pack(push, 1)
+    template <>
+    struct message_header<test::lane_protocol>
+    {
+        using protocol = test::lane_protocol;
+        message_header(test::lane_message_indicator messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        test::lane_message_indicator    messageIndicator_;
+        std::uint16_t                   size_;
+    };
+
+
+    template <>
+    struct message<test::lane_protocol, test::lane_message_indicator::bulk> :
+        message_header<test::lane_protocol>
+    {
+        static auto constexpr type = test::lane_message_indicator::bulk;
+        message(std::uint64_t value = 0):message_header(type, sizeof(*this)), value_(value){}
+        std::uint64_t   value_;
+    };
+
+
+    template <>
+    struct message<test::lane_protocol, test::lane_message_indicator::order> :
+        message_header<test::lane_protocol>
+    {
+        static auto constexpr type = test::lane_message_indicator::order;
+        static auto constexpr lane = 1;
+        message(std::uint64_t value = 0):message_header(type, sizeof(*this)), value_(value){}
+        std::uint64_t   value_;
+    };
+
+
+    template <>
+    struct message<test::lane_protocol, test::lane_message_indicator::cancel> :
+        message_header<test::lane_protocol>
+    {
+        static auto constexpr type = test::lane_message_indicator::cancel;
+        static auto constexpr lane = 2;
+        message(std::uint64_t value = 0):message_header(type, sizeof(*this)), value_(value){}
+        std::uint64_t   value_;
+    };
+    #pragma pack(pop)
+
+} // namespace bcpp::message
+
+
+namespace
+{
+
+    using namespace test;
+
+    using bulk_message = bcpp::message::message<lane_protocol, lane_message_indicator::bulk>;
+    using order_message = bcpp::message::message<lane_protocol, lane_message_indicator::order>;
+    using cancel_message = bcpp::message::message<lane_protocol, lane_message_indicator::cancel>;
+
+    using packet_type = std::vector<char>;
+    using lane_transmitter_type = bcpp::message::lane_transmitter<lane_protocol, packet_type, 3>;
+
+    static_assert(bcpp::message::lane_of<bulk_message> == 0);
+    static_assert(bcpp::message::lane_of<order_message> == 1);
+    static_assert(bcpp::message::lane_of<cancel_message> == 2);
+
+
+    //=========================================================================
+    // every packet handed to the packet handler along with the lane that it was handed over with
+    struct flushed_packet
+    {
+        std::size_t                             lane_;
+        std::vector<lane_message_indicator>     messageIndicators_;
+    };
+
+    std::size_t lane_of_indicator
+    (
+        lane_message_indicator messageIndicator
+    )
+    {
+        switch (messageIndicator)
+        {
+            case lane_message_indicator::bulk: return bcpp::message::lane_of<bulk_message>;
+            case lane_message_indicator::order: return bcpp::message::lane_of<order_message>;
+            case lane_message_indicator::cancel: return bcpp::message::lane_of<cancel_message>;
+        }
+        return lane_transmitter_type::lane_count;
+    }
+
+    auto make_packet_handler
+    (
+        std::vector<flushed_packet> & flushedPackets
+    )
+    {
+        return [&flushedPackets](std::size_t lane, packet_type packet)
+                {
+                    flushed_packet flushedPacket{lane, {}};
+                    for (std::size_t offset = 0; offset < packet.size(); )
+                    {
+                        bcpp::message::message_header<lane_protocol> messageHeader(lane_message_indicator::bulk, 0);
+                        std::memcpy(&messageHeader, packet.data() + offset, sizeof(messageHeader));
+                        flushedPacket.messageIndicators_.push_back(messageHeader.get_message_indicator());
+                        offset += std::max<std::size_t>(messageHeader.size(), 1);
+                    }
+                    flushedPackets.push_back(std::move(flushedPacket));
+                };
+    }
+
+    bool each_packet_holds_only_its_lane
+    (
+        std::vector<flushed_packet> const & flushedPackets
+    )
+    {
+        for (auto const & flushedPacket : flushedPackets)
+            for (auto messageIndicator : flushedPacket.messageIndicators_)
+                if (lane_of_indicator(messageIndicator) != flushedPacket.lane_)
+                    return false;
+        return true;
+    }
+
+
+    //=========================================================================
+    void messages_are_routed_to_their_lane
+    (
+    )
+    {
+        std::vector<flushed_packet> flushedPackets;
+        lane_transmitter_type laneTransmitter({}, {.packetHandler_ = make_packet_handler(flushedPackets)});
+        for (auto i = 0; i < 10; ++i)
+        {
+            laneTransmitter.send(bulk_message(i));
+            laneTransmitter.emplace<order_message>(std::uint64_t(i));
+            if ((i % 3) == 0)
+                laneTransmitter.send(cancel_message(i));
+        }
+        check(flushedPackets.empty(), "nothing is flushed before the packets are full");
+
+        // flush a single lane
+        laneTransmitter.flush(1);
+        check((flushedPackets.size() == 1) && (flushedPackets[0].lane_ == 1) && (flushedPackets[0].messageIndicators_.size() == 10), "flush(lane) flushes only that lane");
+
+        // flush every lane, highest first
+        laneTransmitter.send(order_message());
+        laneTransmitter.flush();
+        check(flushedPackets.size() == 4, "flush() flushes every lane");
+        if (flushedPackets.size() == 4)
+        {
+            check((flushedPackets[1].lane_ == 2) && (flushedPackets[2].lane_ == 1) && (flushedPackets[3].lane_ == 0), "flush() visits the highest lane first");
+            check((flushedPackets[1].messageIndicators_.size() == 4) && (flushedPackets[3].messageIndicators_.size() == 10), "every message is flushed");
+        }
+        check(each_packet_holds_only_its_lane(flushedPackets), "each packet holds only messages of its lane and is handed over with that lane");
+    }
+
+
+    //=========================================================================
+    // the urgent lane flushes every message while bulk traffic waits for a full packet
+    void urgent_lane_does_not_wait_behind_bulk_traffic
+    (
+    )
+    {
+        std::vector<flushed_packet> flushedPackets;
+        lane_transmitter_type::configuration config;
+        config.laneConfigurations_[2].flushPolicy_.maxMessages_ = 1;
+        lane_transmitter_type laneTransmitter(config, {.packetHandler_ = make_packet_handler(flushedPackets)});
+        for (auto i = 0; i < 50; ++i)
+            laneTransmitter.send(bulk_message(i));
+        laneTransmitter.send(cancel_message());
+        check((flushedPackets.size() == 1) && (flushedPackets[0].lane_ == 2) && (flushedPackets[0].messageIndicators_.size() == 1), "the urgent message is flushed at once");
+        laneTransmitter.flush();
+        check((flushedPackets.size() == 2) && (flushedPackets.back().lane_ == 0) && (flushedPackets.back().messageIndicators_.size() == 50), "bulk traffic is flushed later");
+        check(each_packet_holds_only_its_lane(flushedPackets), "each packet is handed over with its lane");
+    }
+
+
+    //=========================================================================
+    void poll_visits_the_highest_lane_first
+    (
+    )
+    {
+        static auto constexpr max_age = std::chrono::milliseconds(1);
+        std::vector<flushed_packet> flushedPackets;
+        lane_transmitter_type::configuration config;
+        for (auto & laneConfiguration : config.laneConfigurations_)
+            laneConfiguration.flushPolicy_.maxAge_ = max_age;
+        lane_transmitter_type laneTransmitter(config, {.packetHandler_ = make_packet_handler(flushedPackets)});
+        auto now = lane_transmitter_type::clock::now();
+        check(!laneTransmitter.poll(now), "nothing to flush");
+        laneTransmitter.send(bulk_message());
+        laneTransmitter.send(cancel_message());
+        laneTransmitter.send(order_message());
+        check(flushedPackets.empty(), "nothing is flushed before it ages");
+        check(laneTransmitter.poll(lane_transmitter_type::clock::now() + (max_age * 10)), "aged packets are flushed");
+        check(flushedPackets.size() == 3, "every lane is flushed");
+        if (flushedPackets.size() == 3)
+            check((flushedPackets[0].lane_ == 2) && (flushedPackets[1].lane_ == 1) && (flushedPackets[2].lane_ == 0), "poll() visits the highest lane first");
+        check(each_packet_holds_only_its_lane(flushedPackets), "each packet is handed over with its lane");
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    messages_are_routed_to_their_lane();
+    urgent_lane_does_not_wait_behind_bulk_traffic();
+    poll_visits_the_highest_lane_first();
+    return test::report("lane_transmitter_test");
+}
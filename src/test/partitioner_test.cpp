@@ -0,0 +1,193 @@
+#include "./test.h"
+#include "./test_protocol.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+
+    using namespace test;
+
+    auto constexpr worker_count = 4;
+    auto constexpr unkeyed_worker = 2;
+    auto constexpr key_count = 37;
+    auto constexpr batch_count = 200;
+    auto constexpr messages_per_batch = 500;
+    auto constexpr worker_packet_capacity = 512;
+
+
+    //=========================================================================
+    // quotes and trades are partitioned by their key.  notes have no key.
+    struct key_extractor
+    {
+        std::uint64_t operator()(quote_message const & quote) const{return quote.key_;}
+        std::uint64_t operator()(trade_message const & trade) const{return trade.key_;}
+    };
+
+    using partitioner_type = bcpp::message::partitioner<test_protocol, key_extractor, std::queue<packet_type>, packet_type>;
+
+
+    //=========================================================================
+    // consumes the packets handed to it by the partitioner on its own thread.  the value of every keyed
+    // message is the next in the sequence of its key (across quotes and trades).
+    class worker :
+        public bcpp::message::receiver<worker, test_protocol, bcpp::message::spsc_packet_queue<packet_type>>
+    {
+    public:
+
+        static auto constexpr packet_queue_capacity = 256;
+
+        worker():receiver({}, {}, packet_queue_capacity){}
+
+        std::unordered_map<std::uint64_t, std::uint64_t>    lastValues_;    // by key
+
+        std::size_t                 keyedMessages_{0};
+
+        std::size_t                 notes_{0};
+
+        bool                        outOfOrder_{false};
+
+    private:
+
+        friend class receiver;
+
+        void on_keyed_message
+        (
+            std::uint64_t key,
+            std::uint64_t value
+        )
+        {
+            auto & lastValue = lastValues_[key];
+            outOfOrder_ |= (value != (lastValue + 1));
+            lastValue = value;
+            ++keyedMessages_;
+        }
+
+        void operator()(quote_message const & quote){on_keyed_message(quote.key_, quote.value_);}
+
+        void operator()(trade_message const & trade){on_keyed_message(trade.key_, trade.value_);}
+
+        void operator()(note_message const &){++notes_;}
+    };
+
+
+    //=========================================================================
+    void partitions_by_key_and_preserves_per_key_order
+    (
+    )
+    {
+        std::vector<std::unique_ptr<worker>> workers;
+        for (auto i = 0; i < worker_count; ++i)
+            workers.push_back(std::make_unique<worker>());
+
+        std::size_t packetsHandedOff = 0;
+        std::size_t bytesHandedOff = 0;
+        partitioner_type partitioner(
+                {
+                    .workerCount_ = worker_count,
+                    .unkeyedWorker_ = unkeyed_worker,
+                    .workerTransmitterConfiguration_ = {.packetCapacity_ = worker_packet_capacity}
+                },
+                {
+                    .workerPacketHandler_ = [&](std::size_t workerIndex, packet_type && packet)
+                            {
+                                ++packetsHandedOff;
+                                bytesHandedOff += packet.size();
+                                *workers[workerIndex] << std::move(packet);
+                            }
+                });
+        check(partitioner.get_worker_count() == worker_count, "worker count");
+        check(partitioner.get_worker_index(note_message()) == unkeyed_worker, "unkeyed messages go to the unkeyed worker");
+        check(partitioner.get_worker_index(quote_message(5)) == partitioner.get_worker_index(trade_message(5)), "the worker depends only on the key");
+
+        std::atomic<bool> done{false};
+        std::vector<std::thread> threads;
+        for (auto & w : workers)
+            threads.emplace_back([&done, &w]()
+                    {
+                        while (!done.load(std::memory_order_acquire))
+                            if (w->process_all() == 0)
+                                std::this_thread::yield();
+                        w->process_all();
+                    });
+
+        // feed the partitioner through an upstream transmitter whose packets split messages
+        std::vector<std::uint64_t> values(key_count, 0);
+        std::size_t keyedMessages = 0;
+        std::size_t notes = 0;
+        bcpp::message::transmitter<test_protocol, packet_type> upstream({.packetCapacity_ = 333},
+                {.packetHandler_ = [&](auto const &, packet_type packet){partitioner << std::move(packet);}});
+        for (auto batch = 0; batch < batch_count; ++batch)
+        {
+            for (auto i = 0; i < messages_per_batch; ++i)
+            {
+                std::uint64_t key = ((i * 7) + batch) % key_count;
+                if ((i % 2) == 0)
+                    upstream.send(quote_message(key, ++values[key]));
+                else
+                    upstream.send(trade_message(key, ++values[key]));
+                ++keyedMessages;
+                if ((i % 50) == 0)
+                {
+                    upstream.send(note_message());
+                    ++notes;
+                }
+            }
+            upstream.flush();
+            partitioner.process_all();
+        }
+
+        done.store(true, std::memory_order_release);
+        for (auto & thread : threads)
+            thread.join();
+
+        std::size_t keyedMessagesReceived = 0;
+        std::size_t messagesForwarded = 0;
+        std::vector<int> workerOfKey(key_count, -1);
+        bool keySplit = false;
+        for (auto i = 0; i < worker_count; ++i)
+        {
+            auto const & w = *workers[i];
+            check(!w.outOfOrder_, "messages of each key are received in order");
+            check(w.empty(), "every forwarded byte is consumed");
+            check(w.keyedMessages_ > 0, "keys are spread across every worker");
+            keyedMessagesReceived += w.keyedMessages_;
+            messagesForwarded += partitioner.get_messages_forwarded(i);
+            check(partitioner.get_messages_forwarded(i) == (w.keyedMessages_ + w.notes_), "forwarded count matches the messages received");
+            check((i == unkeyed_worker) ? (w.notes_ == notes) : (w.notes_ == 0), "every unkeyed message goes to the unkeyed worker");
+            for (auto const & [key, lastValue] : w.lastValues_)
+            {
+                keySplit |= ((workerOfKey[key] != -1) && (workerOfKey[key] != i));
+                workerOfKey[key] = i;
+                check(lastValue == values[key], "every message of the key is received");
+            }
+        }
+        check(!keySplit, "each key is handled by a single worker");
+        check(keyedMessagesReceived == keyedMessages, "every keyed message is received");
+        check(messagesForwarded == (keyedMessages + notes), "every message is forwarded");
+
+        // forwarding is batched: packets are only handed off once full or at the end of process_all()
+        auto maxPackets = (bytesHandedOff / (worker_packet_capacity - sizeof(quote_message))) + (worker_count * batch_count) + worker_count;
+        check(packetsHandedOff <= maxPackets, "worker packets are handed off in batches");
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    partitions_by_key_and_preserves_per_key_order();
+    return test::report("partitioner_test");
+}
@@ -0,0 +1,287 @@
+#include "./test.h"
+#include "./test_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+
+    using namespace test;
+
+    auto constexpr messages_per_packet = 16;
+
+
+    //=========================================================================
+    // receives quotes in runs (batch handler) and notes one at a time
+    class batch_recipient :
+        public bcpp::message::receiver<batch_recipient, test_protocol, std::queue<packet_type>>
+    {
+    public:
+
+        batch_recipient
+        (
+            std::chrono::microseconds batchDelay = {}
+        ):
+            receiver({}, {}),
+            batchDelay_(batchDelay)
+        {
+        }
+
+        std::size_t                 batches_{0};
+
+        std::vector<std::uint64_t>  values_;        // of every message in the order received
+
+    private:
+
+        friend class receiver;
+
+        void operator()
+        (
+            std::span<quote_message const> quotes
+        )
+        {
+            ++batches_;
+            for (auto const & quote : quotes)
+                values_.push_back(std::uint64_t{quote.value_}); // copied as the member is packed
+            if (batchDelay_.count() > 0)
+                std::this_thread::sleep_for(batchDelay_);
+        }
+
+        void operator()
+        (
+            note_message const & note
+        )
+        {
+            values_.push_back(std::uint64_t{note.value_});
+        }
+
+        std::chrono::microseconds   batchDelay_;
+    };
+
+
+    //=========================================================================
+    // every packet holds a single run of quotes and must be delivered in a single call (rather than the
+    // first message of each packet alone followed by the rest of the run)
+    void drain_delivers_each_packet_run_in_one_call
+    (
+    )
+    {
+        static auto constexpr packet_count = 500;
+        batch_recipient batchRecipient;
+        std::uint64_t value = 0;
+        for (auto i = 0; i < packet_count; ++i)
+        {
+            packet_type packet;
+            for (auto j = 0; j < messages_per_packet; ++j)
+                append(packet, quote_message(0, value++));
+            batchRecipient << std::move(packet);
+        }
+
+        auto messagesDispatched = batchRecipient.process_all();
+        check(messagesDispatched == (packet_count * messages_per_packet), "every message is dispatched");
+        check(batchRecipient.batches_ == packet_count, "one batch per packet");
+        bool inOrder = (batchRecipient.values_.size() == value);
+        for (std::size_t i = 0; (inOrder) && (i < batchRecipient.values_.size()); ++i)
+            inOrder = (batchRecipient.values_[i] == i);
+        check(inOrder, "messages are delivered in order");
+        check(batchRecipient.empty(), "every byte is consumed");
+    }
+
+
+    //=========================================================================
+    // messages which straddle packet boundaries are reassembled and the runs on either side of them are
+    // still delivered in order
+    void drain_reassembles_messages_which_straddle_packets
+    (
+    )
+    {
+        static auto constexpr message_count = 1000;
+        packet_type stream;
+        for (std::uint64_t value = 0; value < message_count; ++value)
+        {
+            if ((value % 7) == 0)
+                append(stream, note_message(0, value));
+            else
+                append(stream, quote_message(0, value));
+        }
+
+        // cut the stream into packets of (relatively prime) sizes which split messages and headers
+        batch_recipient batchRecipient;
+        for (std::size_t offset = 0, size = 1; offset < stream.size(); offset += size, size = ((size * 7) % 61) + 1)
+        {
+            auto end = std::min(stream.size(), offset + size);
+            batchRecipient << packet_type(stream.begin() + offset, stream.begin() + end);
+        }
+
+        auto messagesDispatched = batchRecipient.process_all();
+        check(messagesDispatched == message_count, "every message is dispatched");
+        bool inOrder = (batchRecipient.values_.size() == message_count);
+        for (std::size_t i = 0; (inOrder) && (i < batchRecipient.values_.size()); ++i)
+            inOrder = (batchRecipient.values_[i] == i);
+        check(inOrder, "messages are delivered in order");
+        check(batchRecipient.empty(), "every byte is consumed");
+    }
+
+
+    //=========================================================================
+    // a single message followed by runs of 16 means that the dispatched count never lands on a multiple of
+    // the clock sampling interval.  the deadline must still be honoured.
+    void process_for_samples_the_clock_across_batch_runs
+    (
+    )
+    {
+        static auto constexpr packet_count = 500;
+        static auto constexpr batch_delay = std::chrono::microseconds(200);
+        static auto constexpr duration = std::chrono::milliseconds(2);
+        batch_recipient batchRecipient(batch_delay);
+        packet_type first;
+        append(first, note_message(0, 0));
+        batchRecipient << std::move(first);
+        for (auto i = 0; i < packet_count; ++i)
+        {
+            packet_type packet;
+            for (auto j = 0; j < messages_per_packet; ++j)
+                append(packet, quote_message());
+            batchRecipient << std::move(packet);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto messagesDispatched = batchRecipient.process_for(duration);
+        auto elapsed = (std::chrono::steady_clock::now() - start);
+        // draining everything takes at least packet_count * batch_delay (100ms).  allow generous slack for
+        // oversleeping but far less than that.
+        check(messagesDispatched < (1 + (packet_count * messages_per_packet)), "stops before the backlog is drained");
+        check(elapsed < (duration + (batch_delay * 2 * messages_per_packet) + std::chrono::milliseconds(20)), "stops shortly after the deadline");
+        check(messagesDispatched > 0, "dispatches before the deadline");
+    }
+
+
+    //=========================================================================
+    // quotes are conflated by key.  trades (which provide no conflation key) and notes never are.
+    class conflating_recipient :
+        public bcpp::message::receiver<conflating_recipient, test_protocol, std::queue<packet_type>>
+    {
+    public:
+
+        conflating_recipient
+        (
+            std::size_t conflationThreshold
+        ):
+            receiver({.conflationThreshold_ = conflationThreshold}, {})
+        {
+        }
+
+        std::uint64_t conflation_key
+        (
+            quote_message const & quote
+        ) const
+        {
+            return quote.key_;
+        }
+
+        std::vector<std::pair<test_message_indicator, std::uint64_t>>   received_;     // in the order received
+
+    private:
+
+        friend class receiver;
+
+        template <bcpp::message::message_concept M>
+        void operator()
+        (
+            M const & message
+        )
+        {
+            received_.emplace_back(M::type, std::uint64_t{message.value_});
+        }
+    };
+
+
+    //=========================================================================
+    // a backlog beyond the threshold delivers only the newest quote per key (in its original position)
+    // along with every trade and note in order.  a backlog within the threshold is delivered in full.
+    void conflation_keeps_only_the_newest_message_per_key
+    (
+    )
+    {
+        static auto constexpr key_count = 5;
+        static auto constexpr message_count = 200;
+        packet_type packet;
+        std::vector<std::pair<test_message_indicator, std::uint64_t>> sent;
+        std::vector<std::uint64_t> keys;
+        for (std::uint64_t value = 0; value < message_count; ++value)
+        {
+            auto key = ((value * 3) % key_count);
+            if ((value % 4) == 1)
+            {
+                append(packet, trade_message(key, value));
+                sent.emplace_back(test_message_indicator::trade, value);
+            }
+            else if ((value % 9) == 2)
+            {
+                append(packet, note_message(key, value));
+                sent.emplace_back(test_message_indicator::note, value);
+            }
+            else
+            {
+                append(packet, quote_message(key, value));
+                sent.emplace_back(test_message_indicator::quote, value);
+            }
+            keys.push_back(key);
+        }
+
+        // the survivors: every message other than a quote which is followed by a newer quote of its key
+        std::vector<std::pair<test_message_indicator, std::uint64_t>> expected;
+        std::size_t quotesSuperseded = 0;
+        for (std::size_t i = 0; i < sent.size(); ++i)
+        {
+            bool superseded = false;
+            if (sent[i].first == test_message_indicator::quote)
+                for (auto j = i + 1; (!superseded) && (j < sent.size()); ++j)
+                    superseded = ((sent[j].first == test_message_indicator::quote) && (keys[j] == keys[i]));
+            if (superseded)
+                ++quotesSuperseded;
+            else
+                expected.push_back(sent[i]);
+        }
+
+        check(quotesSuperseded > 0, "the backlog holds superseded quotes");
+        conflating_recipient conflatingRecipient(sizeof(quote_message));
+        conflatingRecipient << packet_type(packet);
+        auto messagesDispatched = conflatingRecipient.process_all();
+        check(messagesDispatched == expected.size(), "only the survivors are dispatched");
+        check(conflatingRecipient.received_ == expected, "the newest quote per key is delivered along with every other message in order");
+        check(conflatingRecipient.get_messages_conflated() == quotesSuperseded, "superseded quotes are counted");
+        check(conflatingRecipient.empty(), "every byte is consumed");
+
+        // within the threshold nothing is conflated
+        conflating_recipient unconflatedRecipient(packet.size());
+        unconflatedRecipient << std::move(packet);
+        check(unconflatedRecipient.process_all() == message_count, "a backlog within the threshold is delivered in full");
+        check(unconflatedRecipient.received_ == sent, "a backlog within the threshold is delivered in order");
+        check(unconflatedRecipient.get_messages_conflated() == 0, "nothing is conflated within the threshold");
+    }
+
+} // namespace
+
+
+//=============================================================================
+int main
+(
+    int,
+    char **
+)
+{
+    drain_delivers_each_packet_run_in_one_call();
+    drain_reassembles_messages_which_straddle_packets();
+    process_for_samples_the_clock_across_batch_runs();
+    conflation_keeps_only_the_newest_message_per_key();
+    return test::report("receiver_test");
+}
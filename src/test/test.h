@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <source_location>
+#include <string_view>
+
+
+namespace test
+{
+
+    inline std::size_t failures = 0;
+
+    // record (and report) a failed check without stopping the test so that every failure is seen
+    inline void check
+    (
+        bool condition,
+        std::string_view description,
+        std::source_location location = std::source_location::current()
+    )
+    {
+        if (condition)
+            return;
+        ++failures;
+        std::cerr << location.file_name() << ':' << location.line() << ": check failed: " << description << '\n';
+    }
+
+
+    // the exit code of the test executable
+    inline int report
+    (
+        std::string_view name
+    )
+    {
+        if (failures == 0)
+            std::cout << name << ": passed\n";
+        else
+            std::cerr << name << ": " << failures << " check(s) failed\n";
+        return (failures == 0) ? 0 : 1;
+    }
+
+} // namespace test
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <library/message.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace test
+{
+
+    // a small protocol of fixed size messages used by the tests.  every message carries a key (such as
+    // an instrument id) and a value (typically a per key sequence number).
+    enum class test_message_indicator : std::uint8_t
+    {
+        quote = 1,
+        trade = 2,
+        note = 3
+    };
+
+    using test_protocol = bcpp::message::protocol
+            <
+                bcpp::message::protocol_traits<"test_protocol", {1, 0, 'a'}, test_message_indicator>,
+                test_message_indicator::quote,
+                test_message_indicator::trade,
+                test_message_indicator::note
+            >;
+
+} // namespace test
+
+
+namespace bcpp::message
+{
+
+    #pragma pack(push, 1)
+    template <>
+    struct message_header<test::test_protocol>
+    {
+        using protocol = test::test_protocol;
+        message_header(test::test_message_indicator messageIndicator, std::uint16_t size):messageIndicator_(messageIndicator), size_(size){}
+        auto get_message_indicator() const{return messageIndicator_;}
+        auto size() const{return size_;}
+        void set_size(std::uint16_t size){size_ = size;}
+        test::test_message_indicator    messageIndicator_;
+        std::uint16_t                   size_;
+    };
+
+
+    template <test::test_protocol::message_indicator M>
+    struct message<test::test_protocol, M> :
+        message_header<test::test_protocol>
+    {
+        static auto constexpr type = M;
+        message(std::uint64_t key = 0, std::uint64_t value = 0):message_header(type, sizeof(*this)), key_(key), value_(value){}
+        static constexpr auto size(){return sizeof(message);} // fixed sized message
+        std::uint64_t   key_;
+        std::uint64_t   value_;
+    };
+    #pragma pack(pop)
+
+} // namespace bcpp::message
+
+
+namespace test
+{
+
+    using quote_message = bcpp::message::message<test_protocol, test_message_indicator::quote>;
+    using trade_message = bcpp::message::message<test_protocol, test_message_indicator::trade>;
+    using note_message = bcpp::message::message<test_protocol, test_message_indicator::note>;
+
+    using packet_type = std::vector<char>;
+
+
+    // serialize a message onto the end of a packet (as a transmitter would)
+    template <bcpp::message::message_concept M>
+    void append
+    (
+        packet_type & packet,
+        M const & message
+    )
+    {
+        auto offset = packet.size();
+        packet.resize(offset + sizeof(message));
+        std::memcpy(packet.data() + offset, &message, sizeof(message));
+    }
+
+} // namespace test